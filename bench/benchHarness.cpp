@@ -0,0 +1,73 @@
+// benchHarness.cpp
+#include "benchHarness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// Every operator new in the process goes through here, counted
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    allocations++;
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+size_t allocationCount() {
+    return allocations;
+}
+
+std::vector<glm::vec4> makePalette(int count, float alpha) {
+    std::vector<glm::vec4> palette;
+    for (int i = 0; i < count; i++) {
+        float t = (float)i / count * 6.2831853f;
+        palette.push_back(glm::vec4(0.5f + 0.5f * std::sin(t), 0.5f + 0.5f * std::sin(t + 2.1f),
+                                    0.5f + 0.5f * std::sin(t + 4.2f), alpha));
+    }
+    return palette;
+}
+
+void printStats(const char* label, std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double s : samples) sum += s;
+    int p99Index = std::max(0, (int)std::ceil(0.99 * samples.size()) - 1);
+    printf("%-12s min %8.3f  avg %8.3f  p99 %8.3f ms\n",
+           label, samples.front(), sum / samples.size(), samples[p99Index]);
+}
+
+void printFrameStats(const FrameStats& stats) {
+    printStats("submit", stats.submitMs);
+    printStats("submit+gpu", stats.frameMs);
+    printf("gl calls/frame %d\n", stats.glCalls);
+    printf("allocations/frame %.2f\n", (double)stats.allocations / stats.frames);
+}
+
+int checkAllocations(const char* bench, const FrameStats& stats) {
+    if (stats.allocations > 0) {
+        fprintf(stderr, "%s: draw/flush allocated %zu times in steady state\n", bench, stats.allocations);
+        return 1;
+    }
+    return 0;
+}
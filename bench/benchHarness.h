@@ -0,0 +1,69 @@
+// benchHarness.h
+// Shared by the renderer benches (text_bench, rect_bench, line_bench): a
+// heap allocation counter, the frame timing loop and the report. Link
+// bench/benchHarness.cpp, it replaces operator new for the whole process.
+#pragma once
+#include "glState/glState.h"
+#include "platform/platform.h"
+
+#include <GLES3/gl3.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+// Calls to operator new so far, in the whole process
+size_t allocationCount();
+
+// Colors around the hue circle, neighbours far apart
+std::vector<glm::vec4> makePalette(int count, float alpha);
+
+// min/avg/p99 of one series, in milliseconds
+void printStats(const char* label, std::vector<double> samples);
+
+struct FrameStats {
+    std::vector<double> submitMs;   // CPU time of submit()
+    std::vector<double> frameMs;    // until the GPU is done
+    int glCalls = 0;                // of the last frame
+    size_t allocations = 0;         // in all timed frames
+    int frames = 0;
+};
+
+// Runs submit() for a few untimed frames first, shader compile and buffer
+// growth happen there, then times `frames` frames of it
+template <typename Submit>
+FrameStats measureFrames(int frames, Submit&& submit) {
+    for (int i = 0; i < 10; i++) {
+        submit();
+        glFinish();
+    }
+
+    FrameStats stats;
+    stats.frames = frames;
+    stats.submitMs.reserve(frames);
+    stats.frameMs.reserve(frames);
+
+    for (int f = 0; f < frames; f++) {
+        glState.beginFrame();
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        double start = platform::nowMs();
+        size_t allocationsBefore = allocationCount();
+        submit();
+        stats.allocations += allocationCount() - allocationsBefore;
+        double submitted = platform::nowMs();
+        glFinish();
+        double done = platform::nowMs();
+
+        stats.submitMs.push_back(submitted - start);
+        stats.frameMs.push_back(done - start);
+        stats.glCalls = glState.callsThisFrame();
+    }
+    return stats;
+}
+
+// Timings, GL calls and allocations per frame
+void printFrameStats(const FrameStats& stats);
+
+// Exit code for the bench: 1, with a message, when the timed frames
+// allocated at all; draw/flush must not once warmed up
+int checkAllocations(const char* bench, const FrameStats& stats);
@@ -0,0 +1,117 @@
+// line_bench.cpp
+// LineRenderer throughput: 2k polylines of 16 points per frame in 50
+// colors and 6 thicknesses, cycling through the join and cap styles so
+// neighbours never share a style. Reports CPU submit time (draw + flush),
+// time until the GPU is done, the GL calls issued per frame and the heap
+// allocations made by draw/flush, which must be zero once warmed up (the
+// exit code says so). --lines N and --points N change the counts.
+// --static creates the lines once as static lines and only draws them.
+//
+// Native only, it needs a GL context: the line_bench CMake target.
+#include "lineRenderer/lineRenderer.h"
+#include "frameData/frameData.h"
+#include "bench/benchHarness.h"
+#include "platform/platform.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static const int COLORS = 50;
+static const int THICKNESSES = 6;
+
+// Owns the renderer so its GL objects go away before the context does
+static int run(int width, int height, int frames, int lineCount, int pointCount, bool useStatic) {
+    frameData.init();
+    frameData.setProjection(glm::ortho(0.0f, (float)width, 0.0f, (float)height));
+    frameData.setScreenSize((float)width, (float)height);
+    frameData.upload();
+
+    LineRenderer renderer;
+    renderer.init();
+
+    std::vector<glm::vec4> palette = makePalette(COLORS, 0.9f);
+
+    // Zigzags spread over the screen, the same every frame
+    std::vector<glm::vec2> points;
+    for (int l = 0; l < lineCount; l++) {
+        glm::vec2 origin(fmodf(l * 37.0f, (float)width - 100.0f), fmodf(l * 11.0f, (float)height - 40.0f));
+        for (int p = 0; p < pointCount; p++) {
+            points.push_back(origin + glm::vec2(p * 100.0f / pointCount, (p & 1) ? 30.0f : 10.0f));
+        }
+    }
+
+    auto styleOf = [&](int l) {
+        LineRenderer::Style style;
+        style.color = palette[l % COLORS];
+        style.thickness = 1.0f + l % THICKNESSES;
+        style.join = (LineRenderer::Join)(l % 3);
+        style.cap = (LineRenderer::Cap)(l / 3 % 3);
+        return style;
+    };
+
+    std::vector<LineRenderer::StaticLines> staticLines;
+    if (useStatic) {
+        for (int l = 0; l < lineCount; l++) {
+            std::vector<glm::vec2> line(points.begin() + (size_t)l * pointCount, points.begin() + (size_t)(l + 1) * pointCount);
+            staticLines.push_back(renderer.createStaticLines(line, styleOf(l)));
+        }
+    }
+
+    auto submit = [&]() {
+        for (int l = 0; l < lineCount; l++) {
+            if (useStatic) {
+                renderer.drawStatic(staticLines[l]);
+                continue;
+            }
+            LineRenderer::Style style = styleOf(l);
+            renderer.draw(points.data() + (size_t)l * pointCount, pointCount, style.color, style.thickness,
+                          style.join, style.cap);
+        }
+        renderer.flush();
+    };
+
+    FrameStats stats = measureFrames(frames, submit);
+
+    printf("%d polylines of %d points, %d colors, %d thicknesses, %d frames%s\n",
+           lineCount, pointCount, COLORS, THICKNESSES, frames, useStatic ? ", static" : "");
+    printFrameStats(stats);
+
+    renderer.cleanup();
+    frameData.cleanup();
+    return checkAllocations("line_bench", stats);
+}
+
+int main(int argc, char** argv) {
+    int frames = 200;
+    int lineCount = 2000;
+    int pointCount = 16;
+    bool useStatic = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--static") == 0) {
+            useStatic = true;
+        } else if (strcmp(argv[i], "--lines") == 0 && i + 1 < argc) {
+            lineCount = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--points") == 0 && i + 1 < argc) {
+            pointCount = std::max(2, atoi(argv[++i]));
+        } else {
+            frames = atoi(argv[i]);
+        }
+    }
+    if (frames < 1) frames = 1;
+
+    int width = 1280, height = 720;
+    if (!platform::createContext(width, height)) {
+        fprintf(stderr, "line_bench: no GL context\n");
+        return 1;
+    }
+
+    int result = run(width, height, frames, lineCount, pointCount, useStatic);
+
+    platform::destroyContext();
+    return result;
+}
@@ -0,0 +1,76 @@
+// metrics_bench.cpp
+// FontMetrics throughput without a GL context: batch measurement of many
+// short labels, and caret stops across one long line, which is where the
+// SIMD prefix sum runs. Also checks the caret stops agree with measure().
+//
+// Natively it is the metrics_bench CMake target. Run it from the build
+// directory, the font is copied there.
+#include "textRenderer/fontMetrics.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps the optimizer from dropping benchmark loops
+static volatile float g_sink;
+
+static double elapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int repeats = argc > 1 ? atoi(argv[1]) : 50;
+    if (repeats < 1) repeats = 1;
+
+    FontMetrics metrics;
+    if (!metrics.load("fonts/Roboto-Medium.font")) {
+        fprintf(stderr, "metrics_bench: cannot load fonts/Roboto-Medium.font, run from the build directory\n");
+        return 1;
+    }
+
+    // Scoreboard-like labels
+    const int labelCount = 100000;
+    std::vector<std::string> labels;
+    labels.reserve(labelCount);
+    for (int i = 0; i < labelCount; i++) {
+        labels.push_back("Player " + std::to_string(i) + ": " + std::to_string(i * 37 % 100000) + " pts");
+    }
+    std::vector<std::string_view> views(labels.begin(), labels.end());
+    std::vector<FontMetrics::Metrics> measured(labelCount);
+
+    double best = 1e30;
+    for (int r = 0; r < repeats; r++) {
+        Clock::time_point start = Clock::now();
+        metrics.measure(views.data(), views.size(), 0.5f, measured.data());
+        best = std::min(best, elapsedUs(start));
+        g_sink = measured[r % labelCount].width;
+    }
+    printf("measure      %d labels   %8.1f us  (%.1f ns/label)\n", labelCount, best, best * 1000.0 / labelCount);
+
+    // One long line, a combat log scrollback say
+    std::string line;
+    while (line.size() < 1 << 16) line += "The quick brown fox jumps over the lazy dog. AVAST! To: ";
+    std::vector<float> carets(line.size() + 1);
+
+    best = 1e30;
+    size_t stops = 0;
+    for (int r = 0; r < repeats; r++) {
+        Clock::time_point start = Clock::now();
+        stops = metrics.caretPositions(line, 0.0f, 0.5f, carets.data(), carets.size());
+        best = std::min(best, elapsedUs(start));
+    }
+    printf("carets       %zu stops %8.1f us  (%.2f ns/stop)\n", stops, best, best * 1000.0 / stops);
+
+    // The prefix sum adds in a different order than measure's running sum;
+    // past a few hundred thousand glyphs float pen positions drift apart
+    float width = metrics.measure(line, 0.5f).width;
+    float last = carets[stops - 1];
+    size_t hit = FontMetrics::hitTest(carets.data(), stops, carets[stops / 2] + 0.1f);
+    printf("end %.3f vs width %.3f, hit test %s\n", last, width, hit == stops / 2 ? "ok" : "wrong");
+    return std::fabs(last - width) <= width * 1e-5f && hit == stops / 2 ? 0 : 1;
+}
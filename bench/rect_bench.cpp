@@ -0,0 +1,182 @@
+// rect_bench.cpp
+// Renderer2D rect throughput: 5k rounded rects per frame in 50 colors, a
+// third filled, a third filled with a border on top and a third border
+// only, interleaved so neighbours never share a style. Reports CPU submit
+// time (queue + flush), time until the GPU is done, the GL calls issued
+// per frame and the heap allocations made by draw/flush, which must be zero
+// once warmed up (the exit code says so). --rects N changes the count.
+// --queue submits through a RenderQueue, labels on every rect in a second
+// pass, the way ButtonManager draws.
+// --sprites draws atlas sprites instead of rects: a few generated images
+// and frames cut from a sheet with Sprite::region, each turned about its
+// center. Before timing it reads back one frame drawn 1:1 and fails if
+// the pixels differ from the source.
+//
+// Native only, it needs a GL context: the rect_bench CMake target.
+#include "renderer2d/renderer2d.h"
+#include "renderQueue/renderQueue.h"
+#include "bench/benchHarness.h"
+#include "platform/platform.h"
+
+#include <GLES3/gl3.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static const int COLORS = 50;
+
+static const int SPRITE_IMAGES = 6;
+static const int SHEET_FRAMES = 4;
+static const int FRAME_SIZE = 16;
+
+// Opaque RGBA8 pattern, different per seed so mixed up texels show
+static std::vector<unsigned char> makePattern(int width, int height, int seed) {
+    std::vector<unsigned char> rgba((size_t)width * height * 4);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            unsigned char* p = &rgba[((size_t)y * width + x) * 4];
+            p[0] = (unsigned char)(x * 255 / std::max(1, width - 1));
+            p[1] = (unsigned char)(y * 255 / std::max(1, height - 1));
+            p[2] = (unsigned char)(((x / 4 + y / 4 + seed) & 1) ? 255 : 40 * seed);
+            p[3] = 255;
+        }
+    }
+    return rgba;
+}
+
+// Owns the renderer so its GL objects go away before the context does
+static int run(int width, int height, int frames, int rects, bool useQueue, bool useSprites) {
+    RenderQueue queue;
+    Renderer2D renderer;
+    renderer.init();
+    renderer.setScreenSize(width, height);
+    if (useQueue) renderer.setRenderQueue(&queue);
+
+    std::vector<glm::vec4> palette = makePalette(COLORS, 0.9f);
+
+    // Images of different sizes plus a sheet of frames side by side
+    std::vector<Sprite> images;
+    for (int i = 0; i < SPRITE_IMAGES; i++) {
+        int size = 8 + 8 * i;
+        std::vector<unsigned char> rgba = makePattern(size, size + 4, i);
+        images.push_back(renderer.addSprite(rgba.data(), size, size + 4));
+    }
+    std::vector<unsigned char> sheetPixels = makePattern(FRAME_SIZE * SHEET_FRAMES, FRAME_SIZE, SPRITE_IMAGES);
+    Sprite sheet = renderer.addSprite(sheetPixels.data(), FRAME_SIZE * SHEET_FRAMES, FRAME_SIZE);
+    std::vector<Sprite> sheetFrames;
+    for (int i = 0; i < SHEET_FRAMES; i++) {
+        sheetFrames.push_back(sheet.region(i * FRAME_SIZE, 0, FRAME_SIZE, FRAME_SIZE));
+    }
+
+    const int columns = 100;
+    const float cellWidth = width / (float)columns;
+    const float cellHeight = 14.0f;
+
+    auto flush = [&]() {
+        if (useQueue) {
+            queue.flush();
+        } else {
+            renderer.flush();
+        }
+    };
+
+    auto submit = [&]() {
+        for (int i = 0; i < rects; i++) {
+            glm::vec2 pos(2.0f + (i % columns) * cellWidth, 2.0f + (i / columns % 50) * cellHeight);
+            float w = cellWidth - 3.0f, h = cellHeight - 3.0f;
+            const glm::vec4& fill = palette[i % COLORS];
+            const glm::vec4& border = palette[(i + COLORS / 2) % COLORS];
+            if (useQueue) queue.setPass(0);
+            if (useSprites) {
+                // Images and sheet frames alternate, so batches mix regions
+                const Sprite& sprite = (i & 1) ? sheetFrames[i / 2 % SHEET_FRAMES] : images[i / 2 % SPRITE_IMAGES];
+                renderer.drawSprite(sprite, pos + glm::vec2(w, h) * 0.5f, glm::vec2(h), i * 0.1f,
+                                    glm::vec2(0.5f), (i % 5) ? glm::vec4(1.0f) : fill);
+                continue;
+            }
+            switch (i % 3) {
+            case 0: renderer.drawFilledRoundedRect(pos, w, h, 4.0f, fill); break;
+            case 1: renderer.drawBorderedRect(pos, w, h, 4.0f, fill, 2.0f, border); break;
+            default: renderer.drawRoundedRect(pos, w, h, 2.0f, 4.0f, border); break;
+            }
+            if (useQueue) {
+                // A label strip on top; the queue regroups these after the
+                // backgrounds, two runs instead of one per rect
+                queue.setPass(1);
+                renderer.drawFilledRect(pos + glm::vec2(2.0f, 2.0f), w - 4.0f, 3.0f, border);
+            }
+        }
+        flush();
+    };
+
+    // One sheet frame unrotated at 1:1 has to come back as its source pixels
+    if (useSprites) {
+        const int frame = 2, x = 32, y = 32;
+        glClear(GL_COLOR_BUFFER_BIT);
+        renderer.drawSprite(sheetFrames[frame], glm::vec2(x, y), glm::vec2(FRAME_SIZE));
+        flush();
+        std::vector<unsigned char> readback(FRAME_SIZE * FRAME_SIZE * 4);
+        glReadPixels(x, y, FRAME_SIZE, FRAME_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, readback.data());
+        int wrong = 0;
+        for (int row = 0; row < FRAME_SIZE; row++) {
+            // Read back bottom row first, the source is top row first
+            const unsigned char* source = &sheetPixels[((size_t)(FRAME_SIZE - 1 - row) * FRAME_SIZE * SHEET_FRAMES
+                                                        + frame * FRAME_SIZE) * 4];
+            const unsigned char* drawn = &readback[(size_t)row * FRAME_SIZE * 4];
+            for (int c = 0; c < FRAME_SIZE * 4; c++) {
+                if (std::abs(source[c] - drawn[c]) > 2) wrong++;
+            }
+        }
+        if (wrong > 0) {
+            fprintf(stderr, "rect_bench: sprite region drew %d channels off its source\n", wrong);
+            renderer.cleanup();
+            return 1;
+        }
+    }
+
+    FrameStats stats = measureFrames(frames, submit);
+
+    if (useSprites) {
+        printf("%d sprites, %d images and %d sheet frames, %d frames%s\n", rects, SPRITE_IMAGES, SHEET_FRAMES,
+               frames, useQueue ? ", queued" : "");
+    } else {
+        printf("%d rounded rects, %d colors, %d frames%s\n", rects, COLORS, frames, useQueue ? ", queued with labels" : "");
+    }
+    printFrameStats(stats);
+    if (useQueue) printf("queue runs/frame %d\n", queue.getLastRuns());
+
+    renderer.cleanup();
+    return checkAllocations("rect_bench", stats);
+}
+
+int main(int argc, char** argv) {
+    int frames = 200;
+    int rects = 5000;
+    bool useQueue = false;
+    bool useSprites = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--queue") == 0) {
+            useQueue = true;
+        } else if (strcmp(argv[i], "--sprites") == 0) {
+            useSprites = true;
+        } else if (strcmp(argv[i], "--rects") == 0 && i + 1 < argc) {
+            rects = std::max(1, atoi(argv[++i]));
+        } else {
+            frames = atoi(argv[i]);
+        }
+    }
+    if (frames < 1) frames = 1;
+
+    int width = 1280, height = 720;
+    if (!platform::createContext(width, height)) {
+        fprintf(stderr, "rect_bench: no GL context\n");
+        return 1;
+    }
+
+    int result = run(width, height, frames, rects, useQueue, useSprites);
+
+    platform::destroyContext();
+    return result;
+}
@@ -0,0 +1,178 @@
+// starship_bench.cpp
+// CPU micro-benchmarks for Starship cell storage and edits. No GL context is
+// needed: edits only touch CPU-side state and GPU sync is deferred to draw.
+//
+// Build (from the repo root):
+//   emcc -std=c++17 -O2 -s USE_WEBGL2=1 -s ALLOW_MEMORY_GROWTH=1 -I. -I./glm ^
+//        bench/starship_bench.cpp starship/starship.cpp logger/logger.cpp glState/glState.cpp ^
+//        frameData/frameData.cpp platform/platform_web.cpp -o starship_bench.js
+//   node starship_bench.js
+//
+// Natively it is the starship_bench CMake target.
+#include "starship/starship.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps the optimizer from dropping benchmark loops
+static volatile float g_sink;
+
+static double elapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+// Fills every cell of a width x height ship inside one edit batch
+static double benchFullShipBuild(int width, int height, int repeats) {
+    Starship ship;
+    ship.setGridSize(width, height);
+
+    int cellCount = width * height * 2;
+    double best = 1e30;
+
+    for (int r = 0; r < repeats; ++r) {
+        Clock::time_point start = Clock::now();
+
+        ship.beginEdit();
+        for (int i = 1; i <= cellCount; ++i) {
+            ship.setCell(i % 3 == 0 ? Starship::CELL_ICE : Starship::CELL_FIRE, i);
+        }
+        ship.commitEdits();
+
+        double us = elapsedUs(start);
+        if (us < best) best = us;
+    }
+
+    return best;
+}
+
+// Array-of-structs cell layout Starship used before CellStore, kept here
+// only as the baseline for the live-cell passes below
+struct LegacyTriangleCell {
+    Starship::CellCategory category;
+    Starship::CellName name;
+    bool cellAlive;
+    int cellNumber;
+    glm::vec2 middleOfTriangle;
+    glm::mat4 transform;
+    float x, y;
+    Starship::CellTexCoords texCoords;
+    Starship::AtlasSprite spriteName;
+    glm::vec4 color;
+    union {
+        Starship::DefenseData defense;
+        Starship::AttackData attack;
+        Starship::UtilityData utility;
+        Starship::JetData jet;
+        Starship::CustomData custom;
+    };
+};
+
+// Gathers the centers of live cells, as updateCannonPositions does, with
+// roughly half of a width x height grid alive
+static void benchLiveCellGather(int width, int height, int repeats) {
+    int cellCount = width * height * 2;
+
+    Starship ship;
+    ship.setGridSize(width, height);
+
+    std::vector<LegacyTriangleCell> legacy(cellCount);
+
+    srand(1234);
+    ship.beginEdit();
+    for (int i = 0; i < cellCount; ++i) {
+        bool alive = rand() % 2 == 0;
+        legacy[i].cellAlive = alive;
+        legacy[i].cellNumber = i + 1;
+        legacy[i].middleOfTriangle = ship.cells.center[i];
+        if (alive) ship.setCell(Starship::CELL_FIRE, i + 1);
+    }
+    ship.commitEdits();
+
+    std::vector<glm::vec2> out(cellCount);
+    double bestAoS = 1e30, bestSoA = 1e30;
+
+    for (int r = 0; r < repeats; ++r) {
+        Clock::time_point start = Clock::now();
+        int count = 0;
+        for (size_t i = 0; i < legacy.size(); ++i) {
+            if (legacy[i].cellAlive) {
+                out[count++] = legacy[i].middleOfTriangle;
+            }
+        }
+        double us = elapsedUs(start);
+        if (us < bestAoS) bestAoS = us;
+        g_sink = out[count / 2].x;
+
+        start = Clock::now();
+        count = 0;
+        ship.cells.forEachAlive([&](int i) {
+            out[count++] = ship.cells.center[i];
+        });
+        us = elapsedUs(start);
+        if (us < bestSoA) bestSoA = us;
+        g_sink = out[count / 2].x;
+    }
+
+    printf("%4dx%-4d live cells %6d | AoS %8.1f us (%zu B/cell) | SoA %8.1f us | %.1fx\n",
+           width, height, ship.cells.aliveCount(), bestAoS, sizeof(LegacyTriangleCell),
+           bestSoA, bestAoS / bestSoA);
+}
+
+// CPU side of one Starship frame on a full ship: a handful of cell edits
+// (about 1% of the grid) followed by the cannon rebuild they trigger
+static double benchFrameCpu(int size, int frames) {
+    Starship ship;
+    ship.setGridSize(size, size);
+
+    int cellCount = ship.cells.size();
+    ship.beginEdit();
+    for (int i = 1; i <= cellCount; ++i) {
+        ship.setCell(Starship::CELL_FIRE, i);
+    }
+    ship.commitEdits();
+    ship.updateCannonPositions();
+
+    int editsPerFrame = std::max(1, cellCount / 100);
+    srand(42);
+
+    Clock::time_point start = Clock::now();
+    for (int f = 0; f < frames; ++f) {
+        ship.beginEdit();
+        for (int e = 0; e < editsPerFrame; ++e) {
+            ship.setCell(Starship::CELL_ICE, 1 + rand() % cellCount);
+        }
+        ship.commitEdits();
+
+        if (ship.cannonsDirty) ship.updateCannonPositions();
+    }
+
+    return elapsedUs(start) / frames;
+}
+
+int main() {
+    printf("Full ship build (best of 20)\n");
+    printf("%8s %10s %12s %12s\n", "grid", "cells", "total us", "ns/cell");
+
+    const int sizes[] = {9, 16, 32, 64, 128};
+    for (int size : sizes) {
+        int cells = size * size * 2;
+        double us = benchFullShipBuild(size, size, 20);
+        printf("%4dx%-4d %10d %12.1f %12.1f\n", size, size, cells, us, us * 1000.0 / cells);
+    }
+
+    printf("\nFrame CPU time vs grid size (1%% of cells edited per frame)\n");
+    printf("%8s %10s %12s\n", "grid", "cells", "us/frame");
+    for (int size : sizes) {
+        printf("%4dx%-4d %10d %12.1f\n", size, size, size * size * 2, benchFrameCpu(size, 200));
+    }
+
+    printf("\nLive cell gather, AoS before vs SoA after (best of 50)\n");
+    benchLiveCellGather(64, 64, 50);
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+// text_bench.cpp
+// TextRenderer throughput: 10k glyphs spread over 50 colors per frame, with
+// neighbouring strings in different colors so nothing batches by accident.
+// Reports CPU submit time (queue + flush), time until the GPU is done, the
+// GL calls issued per frame and the heap allocations made by draw/flush,
+// which must be zero once warmed up (the exit code says so). --layout draws
+// the strings as prebuilt TextLayouts instead, the static label path.
+// --glyphs N changes the glyph count; past 16384 a frame takes several
+// draws from the streaming buffer.
+//
+// Native only, it needs a GL context: the text_bench CMake target. Run it
+// from the build directory, the font is copied there.
+#include "textRenderer/textRenderer.h"
+#include "bench/benchHarness.h"
+#include "platform/platform.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const int COLORS = 50;
+static const int GLYPHS_PER_STRING = 20;
+
+// Owns the renderer so its GL objects go away before the context does
+static int run(int width, int height, int frames, int glyphs, bool useLayouts) {
+    TextRenderer text;
+    if (!text.initialize("fonts/Roboto-Medium.font", width, height)) {
+        fprintf(stderr, "text_bench: cannot load fonts/Roboto-Medium.font, run from the build directory\n");
+        return 1;
+    }
+
+    std::vector<glm::vec4> palette = makePalette(COLORS, 1.0f);
+
+    const std::string line = "Glyph bench 0123456!";
+    const int strings = glyphs / GLYPHS_PER_STRING;
+    const int columns = 10;
+
+    // One layout per label, like a menu would hold them
+    std::vector<TextLayout> layouts;
+    if (useLayouts) {
+        for (int i = 0; i < strings; i++) {
+            layouts.push_back(text.createLayout(line, 0.25f));
+        }
+    }
+
+    auto submit = [&]() {
+        for (int i = 0; i < strings; i++) {
+            float x = 10.0f + (i % columns) * (width / (float)columns);
+            float y = height - 10.0f - (i / columns) * 14.0f;
+            if (useLayouts) {
+                text.draw(layouts[i], x, y, palette[i % COLORS]);
+            } else {
+                text.draw(line, x, y, 0.25f, palette[i % COLORS]);
+            }
+        }
+        text.flush();
+    };
+
+    FrameStats stats = measureFrames(frames, submit);
+
+    printf("%d glyphs, %d colors, %d frames%s\n", glyphs, COLORS, frames, useLayouts ? ", layouts" : "");
+    printFrameStats(stats);
+    return checkAllocations("text_bench", stats);
+}
+
+int main(int argc, char** argv) {
+    int frames = 200;
+    int glyphs = 10000;
+    bool useLayouts = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--layout") == 0) {
+            useLayouts = true;
+        } else if (strcmp(argv[i], "--glyphs") == 0 && i + 1 < argc) {
+            glyphs = std::max(GLYPHS_PER_STRING, atoi(argv[++i]));
+        } else {
+            frames = atoi(argv[i]);
+        }
+    }
+    if (frames < 1) frames = 1;
+
+    int width = 1280, height = 720;
+    if (!platform::createContext(width, height)) {
+        fprintf(stderr, "text_bench: no GL context\n");
+        return 1;
+    }
+
+    int result = run(width, height, frames, glyphs, useLayouts);
+
+    platform::destroyContext();
+    return result;
+}
@@ -6,7 +6,7 @@ emcc -std=c++17 -O2 ^
  -s FULL_ES3=1 ^
  -s WASM=1 ^
  -s ALLOW_MEMORY_GROWTH=1 ^
- -s USE_FREETYPE=1 ^
+ -DTEXT_RENDERER_NO_FREETYPE ^
  -I. ^
  -I./glm ^
  -I./button ^
@@ -18,13 +18,24 @@ emcc -std=c++17 -O2 ^
  --preload-file background_tile.png ^
  --preload-file crack_mask.png ^
  --preload-file cannon.png ^
- --preload-file assets/fonts/roboto/Roboto-Medium.ttf@fonts/Roboto-Medium.ttf ^
+ --preload-file assets/fonts/roboto/Roboto-Medium.font@fonts/Roboto-Medium.font ^
  main.cpp ^
  starship/starship.cpp ^
  lineRenderer/lineRenderer.cpp ^
  textRenderer/textRenderer.cpp ^
+ textRenderer/fontAtlas.cpp ^
+ textRenderer/glyphCache.cpp ^
+ textRenderer/fontMetrics.cpp ^
  renderer2d/renderer2d.cpp ^
+ renderer2d/spriteAtlas.cpp ^
+ shelfPacker/shelfPacker.cpp ^
+ renderQueue/renderQueue.cpp ^
  button/button.cpp ^
+ logger/logger.cpp ^
+ platform/platform_web.cpp ^
+ profiler/profiler.cpp ^
+ glState/glState.cpp ^
+ frameData/frameData.cpp ^
  -o main.js
 if errorlevel 1 (
     echo Build failed!
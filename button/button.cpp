@@ -1,8 +1,8 @@
 // Button.cpp
-#include "Button.h"
+#include "button.h"
 #include <algorithm>
 
-ButtonManager::ButtonManager() : textRenderer(nullptr), renderer2d(nullptr), activeButton(nullptr) {
+ButtonManager::ButtonManager() : textRenderer(nullptr), renderer2d(nullptr), renderQueue(nullptr), activeButton(nullptr) {
 }
 
 ButtonManager::~ButtonManager() {
@@ -12,9 +12,10 @@ ButtonManager::~ButtonManager() {
     buttons.clear();
 }
 
-void ButtonManager::init(TextRenderer* textRenderer, Renderer2D* renderer2d) {
+void ButtonManager::init(TextRenderer* textRenderer, Renderer2D* renderer2d, RenderQueue* renderQueue) {
     this->textRenderer = textRenderer;
     this->renderer2d = renderer2d;
+    this->renderQueue = renderQueue;
 }
 
 bool ButtonManager::isInsideButton(const Button* button, float x, float y) {
@@ -77,53 +78,34 @@ bool ButtonManager::fingerRelease(float x, float y) {
 }
 
 void ButtonManager::drawButtons() {
-    // Draw backgrounds
+    // Draw backgrounds, fill and border as one rect
     for (auto* button : buttons) {
-        if (button->borderRadius > 0) {
-            renderer2d->drawFilledRoundedRect(
-                glm::vec2(button->x, button->y),
-                button->width,
-                button->height,
-                button->borderRadius,
-                button->color
-            );
-            
-            if (button->borderWidth > 0) {
-                renderer2d->drawRoundedRect(
-                    glm::vec2(button->x, button->y),
-                    button->width,
-                    button->height,
-                    button->borderWidth,
-                    button->borderRadius,
-                    button->borderColor
-                );
-            }
-        } else {
-            renderer2d->drawFilledRect(
-                glm::vec2(button->x, button->y),
-                button->width,
-                button->height,
-                button->color
-            );
-            
-            if (button->borderWidth > 0) {
-                renderer2d->drawRect(
-                    glm::vec2(button->x, button->y),
-                    button->width,
-                    button->height,
-                    button->borderWidth,
-                    button->borderColor
-                );
-            }
-        }
+        renderer2d->drawBorderedRect(
+            glm::vec2(button->x, button->y),
+            button->width,
+            button->height,
+            std::max(button->borderRadius, 0.0f),
+            button->color,
+            std::max(button->borderWidth, 0.0f),
+            button->borderColor
+        );
     }
     
-    renderer2d->flush();
+    uint32_t pass = 0;
+    if (renderQueue) {
+        pass = renderQueue->getPass();
+        renderQueue->setPass(pass + 1);
+    } else {
+        renderer2d->flush();
+    }
     
     // Draw text and images
     for (auto* button : buttons) {
-        float textWidth, textHeight, textAscent, textDescent;
-        textRenderer->getStringMetrics(button->text, button->textScale, textWidth, textHeight, textAscent, textDescent);
+        if (button->label.getText() != button->text || button->label.getScale() != button->textScale) {
+            button->label = textRenderer->createLayout(button->text, button->textScale);
+        }
+        float textWidth = button->label.getWidth();
+        float textHeight = button->label.getHeight();
         
         if (button->textureId != 0) {
             float textPosX, textPosY;
@@ -170,7 +152,7 @@ void ButtonManager::drawButtons() {
             }
             
             if (!button->text.empty()) {
-                textRenderer->draw(button->text, textPosX, textPosY, button->textScale, button->textColor);
+                textRenderer->draw(button->label, textPosX, textPosY, button->textColor);
             }
             
             renderer2d->drawImage(button->textureId, imagePosX, imagePosY, button->imageWidth, button->imageHeight);
@@ -179,12 +161,16 @@ void ButtonManager::drawButtons() {
             float textPosX = (button->x + button->width / 2) - textWidth / 2;
             float textPosY = (button->y + button->height / 2) - textHeight / 2;
             
-            textRenderer->draw(button->text, textPosX, textPosY, button->textScale, button->textColor);
+            textRenderer->draw(button->label, textPosX, textPosY, button->textColor);
         }
     }
     
-    renderer2d->flush();
-    textRenderer->flush();
+    if (renderQueue) {
+        renderQueue->setPass(pass);
+    } else {
+        renderer2d->flush();
+        textRenderer->flush();
+    }
 }
 
 void ButtonManager::setColor(Button* button, glm::vec4 color) {
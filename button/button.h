@@ -5,8 +5,8 @@
 #include <functional>
 #include <glm/glm.hpp>
 #include <GLES3/gl3.h>
-#include "TextRenderer.h"
-#include "Renderer2D.h"
+#include "textRenderer/textRenderer.h"
+#include "renderer2d/renderer2d.h"
 
 struct Button {
     float x = 0, y = 0;
@@ -23,6 +23,7 @@ struct Button {
     float imageGap = 10;
     std::string drawImage;  // "top", "left", "center"
     std::function<void(Button*)> callback;
+    TextLayout label;       // text laid out by ButtonManager, redone when text or textScale change
 };
 
 class ButtonManager {
@@ -30,7 +31,10 @@ public:
     ButtonManager();
     ~ButtonManager();
     
-    void init(TextRenderer* textRenderer, Renderer2D* renderer2d);
+    // With a queue the renderers are attached to, backgrounds go in its
+    // current pass and images and labels in the next one, and drawButtons
+    // leaves the flushing to the queue
+    void init(TextRenderer* textRenderer, Renderer2D* renderer2d, RenderQueue* renderQueue = nullptr);
     
     Button* createButton(const Button& config);
     void removeButton(Button* button);
@@ -48,6 +52,7 @@ private:
     
     TextRenderer* textRenderer;
     Renderer2D* renderer2d;
+    RenderQueue* renderQueue;
     std::vector<Button*> buttons;
     Button* activeButton = nullptr;
 };
\ No newline at end of file
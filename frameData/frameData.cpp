@@ -0,0 +1,87 @@
+// FrameData.cpp
+#include "frameData.h"
+#include "glState/glState.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+FrameData frameData;
+
+void FrameData::init() {
+    block.projection = glm::mat4(1.0f);
+    setShipRotation(0.0f);
+
+    glGenBuffers(1, &ubo);
+    glState.bindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), &block, GL_DYNAMIC_DRAW);
+
+    // The indexed binding stays put, shaders find the block on BINDING
+    glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, ubo);
+
+    dirtyBegin = dirtyEnd = 0;
+}
+
+void FrameData::cleanup() {
+    glState.deleteBuffer(ubo);
+    ubo = 0;
+}
+
+void FrameData::bindProgram(GLuint program) {
+    GLuint index = glGetUniformBlockIndex(program, "FrameData");
+    if (index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, index, BINDING);
+    }
+}
+
+void FrameData::markDirty(size_t offset, size_t size) {
+    if (dirtyBegin == dirtyEnd) {
+        dirtyBegin = offset;
+        dirtyEnd = offset + size;
+    } else {
+        dirtyBegin = std::min(dirtyBegin, offset);
+        dirtyEnd = std::max(dirtyEnd, offset + size);
+    }
+}
+
+void FrameData::setProjection(const glm::mat4& projection) {
+    if (block.projection == projection) return;
+    block.projection = projection;
+    markDirty(offsetof(Block, projection), sizeof(block.projection));
+}
+
+void FrameData::setShipRotation(float radians) {
+    // shipRotation[2].z is 0 until the first call fills the matrix
+    if (block.shipAngle == radians && block.shipRotation[2].z == 1.0f) return;
+
+    float c = cosf(radians);
+    float s = sinf(radians);
+    block.shipRotation[0] = glm::vec4(c, s, 0.0f, 0.0f);
+    block.shipRotation[1] = glm::vec4(-s, c, 0.0f, 0.0f);
+    block.shipRotation[2] = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+    block.shipAngle = radians;
+
+    markDirty(offsetof(Block, shipRotation), sizeof(block.shipRotation));
+    markDirty(offsetof(Block, shipAngle), sizeof(block.shipAngle));
+}
+
+void FrameData::setScreenSize(float width, float height) {
+    glm::vec2 size(width, height);
+    if (block.screenSize == size) return;
+    block.screenSize = size;
+    markDirty(offsetof(Block, screenSize), sizeof(block.screenSize));
+}
+
+void FrameData::setTime(float seconds) {
+    if (block.time == seconds) return;
+    block.time = seconds;
+    markDirty(offsetof(Block, time), sizeof(block.time));
+}
+
+void FrameData::upload() {
+    if (ubo == 0 || dirtyBegin == dirtyEnd) return;
+
+    glState.bindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, dirtyBegin, dirtyEnd - dirtyBegin,
+                    reinterpret_cast<const char*>(&block) + dirtyBegin);
+    dirtyBegin = dirtyEnd = 0;
+}
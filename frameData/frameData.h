@@ -0,0 +1,58 @@
+// FrameData.h
+#pragma once
+#include <GLES3/gl3.h>
+#include <glm/glm.hpp>
+
+// GLSL side of the per-frame uniform block. Paste it right after the
+// #version line of any shader that needs it:
+//   "#version 300 es\n" FRAME_DATA_GLSL R"( ... )"
+// Members are highp so vertex and fragment stages agree on precision.
+#define FRAME_DATA_GLSL                         \
+    "layout(std140) uniform FrameData {\n"      \
+    "    highp mat4 uProjection;\n"             \
+    "    highp mat3 uShipRotation;\n"           \
+    "    highp vec2 uScreenSize;\n"             \
+    "    highp float uTime;\n"                  \
+    "    highp float uShipAngle;\n"             \
+    "};\n"
+
+// Data shared by every world-space shader, kept in one std140 uniform
+// buffer on a fixed binding point. Setters only mark the bytes that
+// changed; upload() sends that range once per frame.
+class FrameData {
+public:
+    static const GLuint BINDING = 0;
+
+    void init();
+    void cleanup();
+
+    // Hooks a linked program's FrameData block up to BINDING
+    static void bindProgram(GLuint program);
+
+    void setProjection(const glm::mat4& projection);
+    void setShipRotation(float radians);
+    void setScreenSize(float width, float height);
+    void setTime(float seconds);
+
+    void upload();
+
+private:
+    // std140 layout, must match FRAME_DATA_GLSL
+    struct Block {
+        glm::mat4 projection;        // offset 0
+        glm::vec4 shipRotation[3];   // offset 64, mat3 columns padded to vec4
+        glm::vec2 screenSize;        // offset 112
+        float time;                  // offset 120
+        float shipAngle;             // offset 124
+    };
+    static_assert(sizeof(Block) == 128, "FrameData block must match std140");
+
+    void markDirty(size_t offset, size_t size);
+
+    Block block = {};
+    GLuint ubo = 0;
+    size_t dirtyBegin = 0;   // dirty byte range [begin, end)
+    size_t dirtyEnd = 0;
+};
+
+extern FrameData frameData;
@@ -0,0 +1,152 @@
+// GLState.cpp
+#include "glState.h"
+
+GLState glState;
+
+void GLState::useProgram(GLuint program) {
+    if (this->program == program) { frameSkipped++; return; }
+    this->program = program;
+    glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint vao) {
+    if (this->vao == vao) { frameSkipped++; return; }
+    this->vao = vao;
+    glBindVertexArray(vao);
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+    GLuint* cached = nullptr;
+    if (target == GL_ARRAY_BUFFER) cached = &arrayBuffer;
+    else if (target == GL_UNIFORM_BUFFER) cached = &uniformBuffer;
+
+    if (cached) {
+        if (*cached == buffer) { frameSkipped++; return; }
+        *cached = buffer;
+    }
+    glBindBuffer(target, buffer);
+}
+
+void GLState::bindTexture(int unit, GLuint texture) {
+    if (unit < 0 || unit >= MAX_TEXTURE_UNITS) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        activeUnit = unit;
+        return;
+    }
+
+    if (textures[unit] == texture) { frameSkipped++; return; }
+
+    if (activeUnit != unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+    }
+    textures[unit] = texture;
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GLState::bindFramebuffer(GLenum target, GLuint framebuffer) {
+    bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+
+    if ((!draw || drawFramebuffer == framebuffer) && (!read || readFramebuffer == framebuffer)) {
+        frameSkipped++;
+        return;
+    }
+    if (draw) drawFramebuffer = framebuffer;
+    if (read) readFramebuffer = framebuffer;
+    glBindFramebuffer(target, framebuffer);
+}
+
+void GLState::setBlend(bool enabled) {
+    if (blendEnabled == (int)enabled) { frameSkipped++; return; }
+    blendEnabled = enabled;
+    if (enabled) glEnable(GL_BLEND);
+    else glDisable(GL_BLEND);
+}
+
+void GLState::blendFunc(GLenum src, GLenum dst) {
+    if (blendSrc == src && blendDst == dst) { frameSkipped++; return; }
+    blendSrc = src;
+    blendDst = dst;
+    glBlendFunc(src, dst);
+}
+
+void GLState::viewport(int x, int y, int width, int height) {
+    if (viewportRect[0] == x && viewportRect[1] == y &&
+        viewportRect[2] == width && viewportRect[3] == height) {
+        frameSkipped++;
+        return;
+    }
+    viewportRect[0] = x;
+    viewportRect[1] = y;
+    viewportRect[2] = width;
+    viewportRect[3] = height;
+    glViewport(x, y, width, height);
+}
+
+void GLState::deleteProgram(GLuint program) {
+    if (program == 0) return;
+    // A deleted program stays current until something else is used,
+    // but its name can be handed out again
+    if (this->program == program) this->program = UNKNOWN;
+    uniformLocations.erase(program);
+    glDeleteProgram(program);
+}
+
+void GLState::deleteVertexArray(GLuint vao) {
+    if (vao == 0) return;
+    if (this->vao == vao) this->vao = 0;
+    glDeleteVertexArrays(1, &vao);
+}
+
+void GLState::deleteBuffer(GLuint buffer) {
+    if (buffer == 0) return;
+    if (arrayBuffer == buffer) arrayBuffer = 0;
+    if (uniformBuffer == buffer) uniformBuffer = 0;
+    glDeleteBuffers(1, &buffer);
+}
+
+void GLState::deleteTexture(GLuint texture) {
+    if (texture == 0) return;
+    for (int i = 0; i < MAX_TEXTURE_UNITS; i++) {
+        if (textures[i] == texture) textures[i] = 0;
+    }
+    glDeleteTextures(1, &texture);
+}
+
+void GLState::deleteFramebuffer(GLuint framebuffer) {
+    if (framebuffer == 0) return;
+    if (drawFramebuffer == framebuffer) drawFramebuffer = 0;
+    if (readFramebuffer == framebuffer) readFramebuffer = 0;
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+void GLState::invalidate() {
+    program = UNKNOWN;
+    vao = UNKNOWN;
+    arrayBuffer = UNKNOWN;
+    uniformBuffer = UNKNOWN;
+    drawFramebuffer = UNKNOWN;
+    readFramebuffer = UNKNOWN;
+    for (int i = 0; i < MAX_TEXTURE_UNITS; i++) textures[i] = UNKNOWN;
+    activeUnit = -1;
+    blendEnabled = -1;
+    blendSrc = blendDst = 0;
+    for (int i = 0; i < 4; i++) viewportRect[i] = -1;
+}
+
+GLint GLState::uniformLocation(GLuint program, const char* name) {
+    auto& locations = uniformLocations[program];
+    auto it = locations.find(name);
+    if (it != locations.end()) return it->second;
+
+    GLint location = glGetUniformLocation(program, name);
+    locations.emplace(name, location);
+    return location;
+}
+
+void GLState::beginFrame() {
+    frameCalls = 0;
+    frameSkipped = 0;
+}
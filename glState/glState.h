@@ -0,0 +1,117 @@
+// GLState.h
+#pragma once
+#include <GLES3/gl3.h>
+#include <string>
+#include <unordered_map>
+
+// Shadow copy of the GL bindings the renderers share: program, VAO, array
+// and uniform buffers, 2D textures per unit, framebuffers, blend and
+// viewport. Setters skip the GL call when the state is already current, so
+// renderers bind what they need and never unbind after drawing.
+//
+// Every bind of a tracked kind has to go through here, including during
+// init, or the cache drifts. Code that touches GL behind its back calls
+// invalidate().
+class GLState {
+public:
+    static const int MAX_TEXTURE_UNITS = 16;
+
+    GLState() { invalidate(); }
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vao);
+    // GL_ARRAY_BUFFER and GL_UNIFORM_BUFFER are cached; other targets
+    // (GL_ELEMENT_ARRAY_BUFFER is VAO state) go straight to GL
+    void bindBuffer(GLenum target, GLuint buffer);
+    void bindTexture(int unit, GLuint texture);          // GL_TEXTURE_2D
+    void bindFramebuffer(GLenum target, GLuint framebuffer);
+    void setBlend(bool enabled);
+    void blendFunc(GLenum src, GLenum dst);
+    void viewport(int x, int y, int width, int height);
+
+    // GL resets bindings of deleted objects to 0, these keep the cache in step
+    void deleteProgram(GLuint program);
+    void deleteVertexArray(GLuint vao);
+    void deleteBuffer(GLuint buffer);
+    void deleteTexture(GLuint texture);
+    void deleteFramebuffer(GLuint framebuffer);
+
+    // Forget everything, the next setter of each kind always reaches GL
+    void invalidate();
+
+    // Uniform location registry, each (program, name) pair is queried once.
+    // Still a hash lookup: resolve at init and keep the GLint in the renderer.
+    GLint uniformLocation(GLuint program, const char* name);
+
+    // Per-frame counters. calls = GL functions issued from code that includes
+    // this header, skipped = redundant state changes the cache filtered out.
+    void beginFrame();
+    void countCall() { frameCalls++; }
+    int callsThisFrame() const { return frameCalls; }
+    int skippedThisFrame() const { return frameSkipped; }
+
+private:
+    static const GLuint UNKNOWN = 0xFFFFFFFFu;
+
+    GLuint program = UNKNOWN;
+    GLuint vao = UNKNOWN;
+    GLuint arrayBuffer = UNKNOWN;
+    GLuint uniformBuffer = UNKNOWN;
+    GLuint drawFramebuffer = UNKNOWN;
+    GLuint readFramebuffer = UNKNOWN;
+    GLuint textures[MAX_TEXTURE_UNITS];
+    int activeUnit = -1;
+
+    int blendEnabled = -1;   // -1 unknown
+    GLenum blendSrc = 0;
+    GLenum blendDst = 0;
+    int viewportRect[4] = {-1, -1, -1, -1};
+
+    std::unordered_map<GLuint, std::unordered_map<std::string, GLint>> uniformLocations;
+
+    int frameCalls = 0;
+    int frameSkipped = 0;
+};
+
+extern GLState glState;
+
+// Count GL calls made by every translation unit that includes this header.
+// A function-like macro is not re-expanded inside its own body, so the inner
+// call reaches the real GL entry point. Build with -DGL_STATE_NO_CALL_COUNT
+// to compile the counting out.
+#ifndef GL_STATE_NO_CALL_COUNT
+#define GL_STATE_COUNTED(fn, ...) (glState.countCall(), fn(__VA_ARGS__))
+
+#define glUseProgram(...)              GL_STATE_COUNTED(glUseProgram, __VA_ARGS__)
+#define glBindVertexArray(...)         GL_STATE_COUNTED(glBindVertexArray, __VA_ARGS__)
+#define glBindBuffer(...)              GL_STATE_COUNTED(glBindBuffer, __VA_ARGS__)
+#define glBindBufferBase(...)          GL_STATE_COUNTED(glBindBufferBase, __VA_ARGS__)
+#define glBindTexture(...)             GL_STATE_COUNTED(glBindTexture, __VA_ARGS__)
+#define glActiveTexture(...)           GL_STATE_COUNTED(glActiveTexture, __VA_ARGS__)
+#define glBindFramebuffer(...)         GL_STATE_COUNTED(glBindFramebuffer, __VA_ARGS__)
+#define glEnable(...)                  GL_STATE_COUNTED(glEnable, __VA_ARGS__)
+#define glDisable(...)                 GL_STATE_COUNTED(glDisable, __VA_ARGS__)
+#define glBlendFunc(...)               GL_STATE_COUNTED(glBlendFunc, __VA_ARGS__)
+#define glViewport(...)                GL_STATE_COUNTED(glViewport, __VA_ARGS__)
+#define glClear(...)                   GL_STATE_COUNTED(glClear, __VA_ARGS__)
+#define glClearColor(...)              GL_STATE_COUNTED(glClearColor, __VA_ARGS__)
+#define glGetUniformLocation(...)      GL_STATE_COUNTED(glGetUniformLocation, __VA_ARGS__)
+#define glUniform1i(...)               GL_STATE_COUNTED(glUniform1i, __VA_ARGS__)
+#define glUniform1f(...)               GL_STATE_COUNTED(glUniform1f, __VA_ARGS__)
+#define glUniform2f(...)               GL_STATE_COUNTED(glUniform2f, __VA_ARGS__)
+#define glUniform4f(...)               GL_STATE_COUNTED(glUniform4f, __VA_ARGS__)
+#define glUniform4fv(...)              GL_STATE_COUNTED(glUniform4fv, __VA_ARGS__)
+#define glUniformMatrix3fv(...)        GL_STATE_COUNTED(glUniformMatrix3fv, __VA_ARGS__)
+#define glUniformMatrix4fv(...)        GL_STATE_COUNTED(glUniformMatrix4fv, __VA_ARGS__)
+#define glBufferData(...)              GL_STATE_COUNTED(glBufferData, __VA_ARGS__)
+#define glBufferSubData(...)           GL_STATE_COUNTED(glBufferSubData, __VA_ARGS__)
+#define glTexImage2D(...)              GL_STATE_COUNTED(glTexImage2D, __VA_ARGS__)
+#define glTexSubImage2D(...)           GL_STATE_COUNTED(glTexSubImage2D, __VA_ARGS__)
+#define glVertexAttribPointer(...)     GL_STATE_COUNTED(glVertexAttribPointer, __VA_ARGS__)
+#define glEnableVertexAttribArray(...) GL_STATE_COUNTED(glEnableVertexAttribArray, __VA_ARGS__)
+#define glDrawArrays(...)              GL_STATE_COUNTED(glDrawArrays, __VA_ARGS__)
+#define glDrawArraysInstanced(...)     GL_STATE_COUNTED(glDrawArraysInstanced, __VA_ARGS__)
+#define glDrawElements(...)            GL_STATE_COUNTED(glDrawElements, __VA_ARGS__)
+#define glDrawElementsInstanced(...)   GL_STATE_COUNTED(glDrawElementsInstanced, __VA_ARGS__)
+#define glBlitFramebuffer(...)         GL_STATE_COUNTED(glBlitFramebuffer, __VA_ARGS__)
+#endif
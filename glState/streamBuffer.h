@@ -0,0 +1,36 @@
+// StreamBuffer.h
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <GLES3/gl3.h>
+
+// Helpers the instanced renderers share for the per-frame data they stream.
+//
+// Each keeps one GL_STREAM_DRAW buffer used as a ring: draws upload behind
+// the previous one and only a draw that does not fit the rest orphans the
+// buffer, so the driver never waits on a draw still reading it. ES3 has no
+// base instance draws, so every draw points the instance attributes at its
+// first element in the buffer before drawing.
+
+// Color channel as a normalized byte attribute
+inline GLubyte toUnorm8(float value) {
+    return static_cast<GLubyte>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+inline void packUnorm8(const glm::vec4& color, GLubyte out[4]) {
+    out[0] = toUnorm8(color.r);
+    out[1] = toUnorm8(color.g);
+    out[2] = toUnorm8(color.b);
+    out[3] = toUnorm8(color.a);
+}
+
+// Makes room for count elements at ring in the bound GL_ARRAY_BUFFER,
+// orphaning it and doubling capacity until they fit when they do not fit
+// the rest. The caller uploads at ring and advances it.
+inline void reserveStream(size_t& ring, size_t& capacity, size_t count, size_t elementSize) {
+    if (ring + count <= capacity) return;
+    while (capacity < count) capacity *= 2;
+    glBufferData(GL_ARRAY_BUFFER, capacity * elementSize, nullptr, GL_STREAM_DRAW);
+    ring = 0;
+}
@@ -1,26 +1,170 @@
 // LineRenderer.cpp
-#include "LineRenderer.h"
+#include "lineRenderer.h"
+#include "glState/glState.h"
+#include "glState/streamBuffer.h"
+#include "frameData/frameData.h"
+#include "logger/logger.h"
+#include <algorithm>
+#include <cstddef>
+#include <glm/gtc/type_ptr.hpp>
 
 using namespace glm;
 
-static const char* vertSrc = R"(#version 300 es
-uniform mat4 uProjection;
+// Each instance is a segment, its quad comes from gl_VertexID as a 4 vertex
+// strip: along the segment from p0 to p1 plus room for what goes past the
+// ends, across it the half width plus a pixel for the antialiasing.
+// End styles match LineRenderer::EndStyle, caps before joins.
+static const char* vertSrc = "#version 300 es\n" FRAME_DATA_GLSL R"(
+precision highp float;
+const uint END_MITER = 3u;
+const uint END_BEVEL = 4u;
+const float MITER_LIMIT = 4.0;
 uniform float uRotation;
-layout(location = 0) in vec2 aPos;
+uniform mat3 uTransform;        // static lines only, else identity
+layout(location = 0) in vec4 aPrevStart;    // prev.xy, p0.xy
+layout(location = 1) in vec4 aEndNext;      // p1.xy, next.xy
+layout(location = 2) in float aHalfWidth;
+layout(location = 3) in vec4 aColor;
+layout(location = 4) in uvec2 aEnds;        // p0 and p1 end style
+out vec2 vPos;
+flat out vec4 vSegment;     // p0, p1
+flat out vec2 vWidth;       // half width, pixel size
+flat out vec4 vColor;
+flat out vec4 vClip;        // bisector normals at p0 and p1, zero at caps
+flat out vec4 vOuter;       // outer corner directions at p0 and p1
+flat out vec2 vBevel;       // bevel distances from p0 and p1
+flat out uvec2 vEnds;
+
+vec2 place(vec2 p, float c, float s) {
+    p = (uTransform * vec3(p, 1.0)).xy;
+    return vec2(p.x * c - p.y * s, p.x * s + p.y * c);
+}
+
+// End point e, out pointing away from the segment, other toward the next
+// segment of the join. Returns how far past e the end reaches and fills
+// in what the fragment shader needs for it.
+float setupEnd(vec2 e, vec2 dir, vec2 neighbor, float w, float px,
+               inout uint style, out vec2 clip, out vec2 outer, out float bevel) {
+    clip = vec2(0.0);
+    outer = vec2(0.0);
+    bevel = 0.0;
+    if (style < END_MITER) {
+        return (style == 0u ? 0.0 : w) + px;
+    }
+
+    vec2 other = normalize(neighbor - e);
+    vec2 bisector = dir + other;
+    clip = dot(bisector, bisector) > 1e-8 ? normalize(bisector) : dir;
+    vec2 corner = dir - other;
+    if (dot(corner, corner) < 1e-8) {
+        style = END_MITER;      // straight on, nothing to join
+        return px;
+    }
+    outer = normalize(corner);
+    bevel = w * abs(dot(vec2(-dir.y, dir.x), outer));
+    // The miter tip is w / cos away from e, w * tan of that along dir
+    float cosHalf = dot(clip, dir);
+    if (style == END_MITER && cosHalf * MITER_LIMIT < 1.0) {
+        style = END_BEVEL;
+    }
+    if (style == END_MITER) {
+        return w * sqrt(max(1.0 - cosHalf * cosHalf, 0.0)) / cosHalf + px;
+    }
+    return w + px;
+}
+
 void main() {
     float c = cos(uRotation);
     float s = sin(uRotation);
-    vec2 rotated = vec2(aPos.x * c - aPos.y * s, aPos.x * s + aPos.y * c);
-    gl_Position = uProjection * vec4(rotated, 0.0, 1.0);
+    vec2 prev = place(aPrevStart.xy, c, s);
+    vec2 p0 = place(aPrevStart.zw, c, s);
+    vec2 p1 = place(aEndNext.xy, c, s);
+    vec2 next = place(aEndNext.zw, c, s);
+
+    float pixelsPerUnit = 0.5 * min(abs(uProjection[0][0]) * uScreenSize.x, abs(uProjection[1][1]) * uScreenSize.y);
+    float px = 1.0 / max(pixelsPerUnit, 1e-6);
+    float w = aHalfWidth;
+
+    vec2 axis = p1 - p0;
+    float len = length(axis);
+    if (len == 0.0) {
+        gl_Position = vec4(0.0);    // a repeated point of a static line, nothing to draw
+        return;
+    }
+    vec2 d = axis / len;
+    vec2 n = vec2(-d.y, d.x);
+
+    uvec2 ends = aEnds;
+    vec2 clip0, clip1, outer0, outer1;
+    float bevel0, bevel1;
+    float reach0 = setupEnd(p0, -d, prev, w, px, ends.x, clip0, outer0, bevel0);
+    float reach1 = setupEnd(p1, d, next, w, px, ends.y, clip1, outer1, bevel1);
+
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    float along = mix(-reach0, len + reach1, corner.x);
+    float across = mix(-1.0, 1.0, corner.y) * (w + px);
+    vPos = p0 + d * along + n * across;
+    gl_Position = uProjection * vec4(vPos, 0.0, 1.0);
+
+    vSegment = vec4(p0, p1);
+    vWidth = vec2(w, px);
+    vColor = aColor;
+    vClip = vec4(clip0, clip1);
+    vOuter = vec4(outer0, outer1);
+    vBevel = vec2(bevel0, bevel1);
+    vEnds = ends;
 }
 )";
 
+// Distance to the line's edge, negative inside. The body is the band
+// around the segment; past an end the style decides. Joins are split
+// along the bisector so the two segments never cover a pixel twice.
 static const char* fragSrc = R"(#version 300 es
-precision mediump float;
-uniform vec4 uColor;
+precision highp float;
+const uint END_SQUARE = 1u;
+const uint END_ROUND_CAP = 2u;
+const uint END_MITER = 3u;
+const uint END_BEVEL = 4u;
+const uint END_ROUND_JOIN = 5u;
+in vec2 vPos;
+flat in vec4 vSegment;
+flat in vec2 vWidth;
+flat in vec4 vColor;
+flat in vec4 vClip;
+flat in vec4 vOuter;
+flat in vec2 vBevel;
+flat in uvec2 vEnds;
 out vec4 fragColor;
+
+float endDistance(float band, vec2 q, vec2 dir, uint style, vec2 outer, float bevel, float w) {
+    float along = dot(q, dir);
+    if (along <= 0.0) return band;
+    if (style == END_ROUND_CAP || style == END_ROUND_JOIN) return length(q) - w;
+    if (style == END_SQUARE) return max(band, along - w);
+    if (style == END_MITER) return band;
+    if (style == END_BEVEL) return max(band, dot(q, outer) - bevel);
+    return max(band, along);
+}
+
 void main() {
-    fragColor = uColor;
+    vec2 p0 = vSegment.xy;
+    vec2 p1 = vSegment.zw;
+    vec2 d = normalize(p1 - p0);
+    vec2 q0 = vPos - p0;
+    vec2 q1 = vPos - p1;
+    if (dot(q0, vClip.xy) > 0.0 || dot(q1, vClip.zw) > 0.0) {
+        discard;
+    }
+
+    float w = vWidth.x;
+    float band = abs(dot(q0, vec2(-d.y, d.x))) - w;
+    float dist = max(endDistance(band, q0, -d, vEnds.x, vOuter.xy, vBevel.x, w),
+                     endDistance(band, q1, d, vEnds.y, vOuter.zw, vBevel.y, w));
+    float coverage = clamp(0.5 - dist / vWidth.y, 0.0, 1.0);
+    if (coverage <= 0.0) {
+        discard;
+    }
+    fragColor = vec4(vColor.rgb, vColor.a * coverage);
 }
 )";
 
@@ -28,130 +172,287 @@ void LineRenderer::init() {
     GLuint vert = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vert, 1, &vertSrc, nullptr);
     glCompileShader(vert);
-    
+
     GLuint frag = glCreateShader(GL_FRAGMENT_SHADER);
     glShaderSource(frag, 1, &fragSrc, nullptr);
     glCompileShader(frag);
-    
+
     shader = glCreateProgram();
     glAttachShader(shader, vert);
     glAttachShader(shader, frag);
     glLinkProgram(shader);
     glDeleteShader(vert);
     glDeleteShader(frag);
-    
-    projectionLoc = glGetUniformLocation(shader, "uProjection");
-    rotationLoc = glGetUniformLocation(shader, "uRotation");
-    colorLoc = glGetUniformLocation(shader, "uColor");
-    
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(shader, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        GLchar infoLog[512];
+        glGetProgramInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+        LOG_ERROR(LOG_RENDER, "LineRenderer: program link error: %s\n", infoLog);
+    }
+    FrameData::bindProgram(shader);
+
+    rotationLoc = glState.uniformLocation(shader, "uRotation");
+    transformLoc = glState.uniformLocation(shader, "uTransform");
+    glState.useProgram(shader);
+    glUniformMatrix3fv(transformLoc, 1, GL_FALSE, value_ptr(appliedTransform));
+
+    // Every attribute advances per instance, the quad has no vertex data
     glGenVertexArrays(1, &vao);
     glGenBuffers(1, &vbo);
-    
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+    glState.bindVertexArray(vao);
+    glState.bindBuffer(GL_ARRAY_BUFFER, vbo);
+    segmentCapacity = INITIAL_SEGMENTS;
+    ringSegment = 0;
+    glBufferData(GL_ARRAY_BUFFER, segmentCapacity * sizeof(SegmentInstance), nullptr, GL_STREAM_DRAW);
+    for (GLuint attribute = 0; attribute < 5; attribute++) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+    pointAttributes(0);
+    glState.bindVertexArray(0);
+}
+
+// Points the instance attributes at firstSegment of the bound VBO
+void LineRenderer::pointAttributes(size_t firstSegment) {
+    size_t base = firstSegment * sizeof(SegmentInstance);
+    GLsizei stride = sizeof(SegmentInstance);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(SegmentInstance, prev)));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(SegmentInstance, p1)));
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(SegmentInstance, halfWidth)));
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(base + offsetof(SegmentInstance, color)));
+    glVertexAttribIPointer(4, 2, GL_UNSIGNED_BYTE, stride, (void*)(base + offsetof(SegmentInstance, startStyle)));
 }
 
 void LineRenderer::cleanup() {
-    glDeleteProgram(shader);
-    glDeleteVertexArrays(1, &vao);
-    glDeleteBuffers(1, &vbo);
-}
-
-std::vector<vec2> LineRenderer::triangulateLine(const std::vector<vec2>& points, float thickness) {
-    std::vector<vec2> triangulatedLine;
-
-    if (points.size() < 2) {
-        return triangulatedLine;
-    }
-
-    vec2 startLine = normalize(points[1] - points[0]);
-    vec2 normal = vec2(-startLine.y, startLine.x);
-    triangulatedLine.push_back(points[0] - thickness * normal);
-    triangulatedLine.push_back(points[0] + thickness * normal);
-
-    vec2 precedingLine = startLine;
-
-    for (size_t i = 2; i < points.size(); ++i) {
-        vec2 line = normalize(points[i] - points[i - 1]);
-        vec2 tangent = normalize(line + precedingLine);
-        precedingLine = line;
-
-        vec2 normal = vec2(-line.y, line.x);
-        vec2 miter = vec2(-tangent.y, tangent.x);
-        float dot = glm::dot(normal, miter);
-        float length = thickness / dot;
-
-        triangulatedLine.push_back(points[i - 1] - length * miter);
-        triangulatedLine.push_back(points[i - 1] + length * miter);
-    }
-
-    size_t endIndexLine = points.size() - 1;
-    vec2 endLine = normalize(points[endIndexLine] - points[endIndexLine - 1]);
-    normal = vec2(-endLine.y, endLine.x);
-    triangulatedLine.push_back(points[endIndexLine] - thickness * normal);
-    triangulatedLine.push_back(points[endIndexLine] + thickness * normal);
-
-    return triangulatedLine;
-}
-
-void LineRenderer::draw(vec2 from, vec2 to, vec4 color, float thickness) {
-    draw({from, to}, color, thickness);
-}
-
-void LineRenderer::draw(const std::vector<vec2>& points, vec4 color, float thickness) {
-    if (points.size() < 2) return;
-    LineKey key{color, thickness};
-    linesBatch[key].push_back(points);
-}
-
-void LineRenderer::flush(const float* projectionMatrix, float rotation) {
-    if (linesBatch.empty()) return;
-    
-    glUseProgram(shader);
-    glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, projectionMatrix);
-    glUniform1f(rotationLoc, rotation);
-    
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    
-    for (auto& [key, lines] : linesBatch) {
-        if (lines.empty()) continue;
-        
-        std::vector<float> verts;
-        
-        for (auto& points : lines) {
-            auto strip = triangulateLine(points, key.thickness * 0.5f);
-            if (strip.empty()) continue;
-            
-            // Degenerate triangles to connect strips
-            if (!verts.empty()) {
-                verts.push_back(verts[verts.size() - 2]);
-                verts.push_back(verts[verts.size() - 2]);
-                verts.push_back(strip[0].x);
-                verts.push_back(strip[0].y);
-            }
-            
-            for (auto& p : strip) {
-                verts.push_back(p.x);
-                verts.push_back(p.y);
+    for (StaticBuffer& buffer : staticBuffers) {
+        glState.deleteVertexArray(buffer.vao);
+        glState.deleteBuffer(buffer.vbo);
+    }
+    staticBuffers.clear();
+    glState.deleteProgram(shader);
+    glState.deleteVertexArray(vao);
+    glState.deleteBuffer(vbo);
+}
+
+LineRenderer::Stroke LineRenderer::toStroke(const Style& style) {
+    Stroke stroke = {style.thickness * 0.5f, {}, style.join, style.cap};
+    packUnorm8(style.color, stroke.color);
+    return stroke;
+}
+
+void LineRenderer::draw(vec2 from, vec2 to, vec4 color, float thickness, Cap cap) {
+    vec2 points[] = {from, to};
+    draw(points, 2, color, thickness, JOIN_MITER, cap);
+}
+
+void LineRenderer::draw(const std::vector<vec2>& points, vec4 color, float thickness, Join join, Cap cap) {
+    draw(points.data(), points.size(), color, thickness, join, cap);
+}
+
+void LineRenderer::draw(const vec2* points, size_t count, vec4 color, float thickness, Join join, Cap cap) {
+    // Repeated points would make zero length segments
+    uint32_t first = static_cast<uint32_t>(linePoints.size());
+    for (size_t i = 0; i < count; i++) {
+        if (linePoints.size() == first || points[i] != linePoints.back()) linePoints.push_back(points[i]);
+    }
+    uint32_t kept = static_cast<uint32_t>(linePoints.size()) - first;
+    if (kept < 2) {
+        linePoints.resize(first);
+        return;
+    }
+
+    lines.push_back({first, kept, toStroke({color, thickness, join, cap})});
+    uint32_t item = static_cast<uint32_t>(lines.size() - 1);
+    if (renderQueue) {
+        renderQueue->push(shaderId, 0, 0, item);
+    } else {
+        drawOrder.push_back(item);
+    }
+}
+
+LineRenderer::StaticLines LineRenderer::createStaticLines(const std::vector<vec2>& points, const Style& style) {
+    if (points.size() < 2) return 0;
+
+    // Reuse a destroyed slot so handles stay small
+    size_t slot = 0;
+    while (slot < staticBuffers.size() && staticBuffers[slot].vao != 0) slot++;
+    if (slot == staticBuffers.size()) staticBuffers.emplace_back();
+    StaticBuffer& buffer = staticBuffers[slot];
+    buffer.points = points;
+    buffer.stroke = toStroke(style);
+    buffer.transform = mat3(1.0f);
+
+    segments.clear();
+    buildSegments(points.data(), points.size(), 0, points.size() - 1, buffer.stroke);
+
+    glGenVertexArrays(1, &buffer.vao);
+    glGenBuffers(1, &buffer.vbo);
+    glState.bindVertexArray(buffer.vao);
+    glState.bindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+    glBufferData(GL_ARRAY_BUFFER, segments.size() * sizeof(SegmentInstance), segments.data(), GL_STATIC_DRAW);
+    for (GLuint attribute = 0; attribute < 5; attribute++) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+    pointAttributes(0);
+    glState.bindVertexArray(0);
+    return static_cast<StaticLines>(slot + 1);
+}
+
+LineRenderer::StaticBuffer* LineRenderer::findStatic(StaticLines lines) {
+    if (lines == 0 || lines > staticBuffers.size() || staticBuffers[lines - 1].vao == 0) {
+        LOG_ERROR_EVERY(LOG_RENDER, 1000.0, "LineRenderer: no static lines %u\n", lines);
+        return nullptr;
+    }
+    return &staticBuffers[lines - 1];
+}
+
+void LineRenderer::updateStaticLines(StaticLines lines, size_t firstPoint, const vec2* points, size_t count) {
+    StaticBuffer* buffer = findStatic(lines);
+    if (!buffer || count == 0) return;
+    size_t pointCount = buffer->points.size();
+    if (firstPoint + count > pointCount) {
+        LOG_ERROR(LOG_RENDER, "LineRenderer: update of points %zu..%zu past the %zu of static lines %u\n",
+                  firstPoint, firstPoint + count, pointCount, lines);
+        return;
+    }
+    std::copy(points, points + count, buffer->points.begin() + firstPoint);
+
+    // Segment i reads points i - 1 to i + 2
+    size_t first = firstPoint >= 2 ? firstPoint - 2 : 0;
+    size_t last = std::min(firstPoint + count + 1, pointCount - 1);
+    segments.clear();
+    buildSegments(buffer->points.data(), pointCount, first, last, buffer->stroke);
+
+    glState.bindBuffer(GL_ARRAY_BUFFER, buffer->vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(SegmentInstance),
+                    segments.size() * sizeof(SegmentInstance), segments.data());
+}
+
+void LineRenderer::setStaticTransform(StaticLines lines, const mat3& transform) {
+    if (StaticBuffer* buffer = findStatic(lines)) buffer->transform = transform;
+}
+
+void LineRenderer::destroyStaticLines(StaticLines lines) {
+    StaticBuffer* buffer = findStatic(lines);
+    if (!buffer) return;
+    glState.deleteVertexArray(buffer->vao);
+    glState.deleteBuffer(buffer->vbo);
+    *buffer = StaticBuffer();
+}
+
+void LineRenderer::drawStatic(StaticLines lines) {
+    if (!findStatic(lines)) return;
+    uint32_t item = STATIC_ITEM | lines;
+    if (renderQueue) {
+        renderQueue->push(shaderId, 0, 0, item);
+    } else {
+        drawOrder.push_back(item);
+    }
+}
+
+void LineRenderer::setRenderQueue(RenderQueue* queue) {
+    renderQueue = queue;
+    if (queue) shaderId = queue->registerShader(this);
+}
+
+void LineRenderer::flush(float rotation) {
+    this->rotation = rotation;
+    if (renderQueue) return;
+
+    drawItems(drawOrder.data(), drawOrder.size());
+    endFrame();
+}
+
+void LineRenderer::drawRun(uint32_t, const uint32_t* items, size_t count) {
+    drawItems(items, count);
+}
+
+void LineRenderer::endFrame() {
+    lines.clear();
+    linePoints.clear();
+    drawOrder.clear();
+}
+
+void LineRenderer::beginDraw() {
+    glState.setBlend(true);
+    glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glState.useProgram(shader);
+    if (rotation != appliedRotation) {
+        glUniform1f(rotationLoc, rotation);
+        appliedRotation = rotation;
+    }
+}
+
+void LineRenderer::applyTransform(const mat3& transform) {
+    if (transform == appliedTransform) return;
+    glUniformMatrix3fv(transformLoc, 1, GL_FALSE, value_ptr(transform));
+    appliedTransform = transform;
+}
+
+void LineRenderer::drawItems(const uint32_t* items, size_t count) {
+    for (size_t first = 0; first < count;) {
+        if (items[first] & STATIC_ITEM) {
+            // Destroyed since it was queued: skipped
+            StaticLines handle = items[first] & ~STATIC_ITEM;
+            if (handle <= staticBuffers.size() && staticBuffers[handle - 1].vao != 0) {
+                const StaticBuffer& buffer = staticBuffers[handle - 1];
+                beginDraw();
+                applyTransform(buffer.transform);
+                glState.bindVertexArray(buffer.vao);
+                glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(buffer.points.size() - 1));
             }
+            first++;
+            continue;
         }
-        
-        size_t dataSize = verts.size() * sizeof(float);
-        if (dataSize > bufferCapacity) {
-            glBufferData(GL_ARRAY_BUFFER, dataSize, verts.data(), GL_DYNAMIC_DRAW);
-            bufferCapacity = dataSize;
-        } else {
-            glBufferSubData(GL_ARRAY_BUFFER, 0, dataSize, verts.data());
-        }
-        
-        glUniform4f(colorLoc, key.color.r, key.color.g, key.color.b, key.color.a);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, verts.size() / 2);
-    }
-    
-    glBindVertexArray(0);
-    linesBatch.clear();
-}
\ No newline at end of file
+        size_t last = first;
+        while (last < count && !(items[last] & STATIC_ITEM)) last++;
+        drawLines(items + first, last - first);
+        first = last;
+    }
+}
+
+// A repeated point gets a cap on both sides and a zero length segment the
+// shader drops
+void LineRenderer::buildSegments(const vec2* points, size_t count, size_t first, size_t last, const Stroke& stroke) {
+    static const EndStyle capStyles[] = {END_BUTT, END_SQUARE, END_ROUND_CAP};
+    static const EndStyle joinStyles[] = {END_MITER, END_BEVEL, END_ROUND_JOIN};
+    GLubyte cap = capStyles[stroke.cap];
+    GLubyte join = joinStyles[stroke.join];
+
+    for (size_t p = first; p < last; p++) {
+        bool joinsPrev = p > 0 && points[p - 1] != points[p];
+        bool joinsNext = p + 2 < count && points[p + 2] != points[p + 1];
+        vec2 prev = joinsPrev ? points[p - 1] : points[p];
+        vec2 next = joinsNext ? points[p + 2] : points[p + 1];
+        segments.push_back({{prev.x, prev.y}, {points[p].x, points[p].y},
+                            {points[p + 1].x, points[p + 1].y}, {next.x, next.y},
+                            stroke.halfWidth,
+                            {stroke.color[0], stroke.color[1], stroke.color[2], stroke.color[3]},
+                            joinsPrev ? join : cap, joinsNext ? join : cap, {0, 0}});
+    }
+}
+
+void LineRenderer::drawLines(const uint32_t* order, size_t count) {
+    segments.clear();
+    for (size_t i = 0; i < count; i++) {
+        const QueuedLine& line = lines[order[i]];
+        buildSegments(linePoints.data() + line.first, line.count, 0, line.count - 1, line.stroke);
+    }
+    if (segments.empty()) return;
+
+    beginDraw();
+    applyTransform(mat3(1.0f));
+    glState.bindVertexArray(vao);
+    glState.bindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    size_t segmentCount = segments.size();
+    reserveStream(ringSegment, segmentCapacity, segmentCount, sizeof(SegmentInstance));
+    glBufferSubData(GL_ARRAY_BUFFER, ringSegment * sizeof(SegmentInstance),
+                    segmentCount * sizeof(SegmentInstance), segments.data());
+    pointAttributes(ringSegment);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(segmentCount));
+    ringSegment += segmentCount;
+}
@@ -1,42 +1,142 @@
 // LineRenderer.h
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <vector>
-#include <map>
 #include <glm/glm.hpp>
 #include <GLES3/gl3.h>
+#include "renderQueue/renderQueue.h"
 
-class LineRenderer {
+// Polylines in world space, every segment one instance that the vertex
+// shader expands to a quad. The fragment shader cuts each segment at the
+// bisector with its neighbour and shapes joins and caps from distances, so
+// all lines go out in one draw whatever their color, thickness or style.
+class LineRenderer : public RenderBackend {
 public:
+    // Miter joins longer than MITER_LIMIT half widths become bevels
+    enum Join : uint8_t { JOIN_MITER, JOIN_BEVEL, JOIN_ROUND };
+    enum Cap : uint8_t { CAP_BUTT, CAP_SQUARE, CAP_ROUND };
+    static constexpr float MITER_LIMIT = 4.0f;
+
     void init();
     void cleanup();
-    
-    void draw(glm::vec2 from, glm::vec2 to, glm::vec4 color = glm::vec4(1.0f), float thickness = 1.0f);
-    void draw(const std::vector<glm::vec2>& points, glm::vec4 color = glm::vec4(1.0f), float thickness = 1.0f);
-    void flush(const float* projectionMatrix, float rotation = 0.0f);
-    
+
+    struct Style {
+        glm::vec4 color = glm::vec4(1.0f);
+        float thickness = 1.0f;
+        Join join = JOIN_MITER;
+        Cap cap = CAP_BUTT;
+    };
+
+    // Retained polyline, 0 is none
+    using StaticLines = uint32_t;
+
+    void draw(glm::vec2 from, glm::vec2 to, glm::vec4 color = glm::vec4(1.0f), float thickness = 1.0f,
+              Cap cap = CAP_BUTT);
+    void draw(const std::vector<glm::vec2>& points, glm::vec4 color = glm::vec4(1.0f), float thickness = 1.0f,
+              Join join = JOIN_MITER, Cap cap = CAP_BUTT);
+    void draw(const glm::vec2* points, size_t count, glm::vec4 color, float thickness,
+              Join join = JOIN_MITER, Cap cap = CAP_BUTT);
+    // Projection comes from the FrameData block
+    void flush(float rotation = 0.0f);
+
+    // Polylines that rarely change keep their segments in a buffer of their
+    // own, built once; drawStatic() costs a draw call and no upload. A
+    // repeated point breaks the line there, ends capped. The transform
+    // places the points before the rotation, widths stay in world units.
+    StaticLines createStaticLines(const std::vector<glm::vec2>& points, const Style& style);
+    // Moves count points from firstPoint on, the point count stays. Only
+    // the segments touching them are uploaded again.
+    void updateStaticLines(StaticLines lines, size_t firstPoint, const glm::vec2* points, size_t count);
+    void setStaticTransform(StaticLines lines, const glm::mat3& transform);
+    void destroyStaticLines(StaticLines lines);
+    // Drawn in order with the immediate lines, through the queue if attached
+    void drawStatic(StaticLines lines);
+
+    // Draws go to the queue from then on, in its current layer and pass,
+    // and flush() only sets the rotation; the queue draws them
+    void setRenderQueue(RenderQueue* queue);
+    void setRotation(float rotation) { this->rotation = rotation; }
+
+    void drawRun(uint32_t shader, const uint32_t* items, size_t count) override;
+    void endFrame() override;
+
 private:
-    std::vector<glm::vec2> triangulateLine(const std::vector<glm::vec2>& points, float thickness);
-    
-    struct LineKey {
-        glm::vec4 color;
-        float thickness;
-        
-        bool operator<(const LineKey& other) const {
-            if (color.r != other.color.r) return color.r < other.color.r;
-            if (color.g != other.color.g) return color.g < other.color.g;
-            if (color.b != other.color.b) return color.b < other.color.b;
-            if (color.a != other.color.a) return color.a < other.color.a;
-            return thickness < other.thickness;
-        }
+    // Segments the streaming VBO holds before it has to grow
+    static constexpr size_t INITIAL_SEGMENTS = 4096;
+
+    // One instance per segment. prev and next are the neighbouring points
+    // of the polyline, unused at an end that has a cap. The end styles are
+    // EndStyle values for the p0 and p1 ends.
+    struct SegmentInstance {
+        GLfloat prev[2], p0[2];
+        GLfloat p1[2], next[2];
+        GLfloat halfWidth;
+        GLubyte color[4];
+        GLubyte startStyle, endStyle, padding[2];
+    };
+
+    // Style as the shader takes it
+    struct Stroke {
+        float halfWidth;
+        GLubyte color[4];
+        Join join;
+        Cap cap;
     };
-    
+
+    // Points are linePoints[first, first + count), without repeats
+    struct QueuedLine {
+        uint32_t first, count;
+        Stroke stroke;
+    };
+
+    struct StaticBuffer {
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        std::vector<glm::vec2> points;  // kept for partial updates
+        Stroke stroke = {};
+        glm::mat3 transform = glm::mat3(1.0f);
+    };
+
+    // How the shader finishes a segment end, caps and joins in one list
+    enum EndStyle : uint8_t { END_BUTT, END_SQUARE, END_ROUND_CAP, END_MITER, END_BEVEL, END_ROUND_JOIN };
+
+    // Items with this bit are StaticLines, the others index lines
+    static constexpr uint32_t STATIC_ITEM = 0x80000000u;
+
+    static Stroke toStroke(const Style& style);
+    void pointAttributes(size_t firstSegment);
+    // Appends segments [first, last) of the polyline to segments
+    void buildSegments(const glm::vec2* points, size_t count, size_t first, size_t last, const Stroke& stroke);
+    StaticBuffer* findStatic(StaticLines lines);
+    void beginDraw();
+    void applyTransform(const glm::mat3& transform);
+    // Immediate and static lines in the given order, a draw per stretch
+    // of immediate lines and one per static buffer
+    void drawItems(const uint32_t* items, size_t count);
+    // Immediate lines in the given order, all in one draw
+    void drawLines(const uint32_t* order, size_t count);
+
     GLuint shader = 0;
     GLuint vao = 0;
     GLuint vbo = 0;
-    GLint projectionLoc = -1;
     GLint rotationLoc = -1;
-    GLint colorLoc = -1;
-    
-    std::map<LineKey, std::vector<std::vector<glm::vec2>>> linesBatch;
-    size_t bufferCapacity = 0;
-};
\ No newline at end of file
+    GLint transformLoc = -1;
+    float rotation = 0.0f;
+    float appliedRotation = 0.0f;                   // what uRotation holds
+    glm::mat3 appliedTransform = glm::mat3(1.0f);  // what uTransform holds
+    size_t segmentCapacity = 0;     // segments the VBO holds
+    size_t ringSegment = 0;         // next free segment in the VBO
+
+    RenderQueue* renderQueue = nullptr;
+    uint32_t shaderId = 0;
+
+    // By StaticLines - 1, a destroyed slot has no vao until reused
+    std::vector<StaticBuffer> staticBuffers;
+
+    // Reused between flushes
+    std::vector<QueuedLine> lines;
+    std::vector<glm::vec2> linePoints;
+    std::vector<uint32_t> drawOrder;    // items in submission order, standalone only
+    std::vector<SegmentInstance> segments;
+};
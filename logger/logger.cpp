@@ -0,0 +1,46 @@
+// Logger.cpp
+#include "logger.h"
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+
+namespace logger {
+
+static const char* categoryName(uint32_t category) {
+    switch (category) {
+        case LOG_RENDER: return "render";
+        case LOG_ASSET:  return "asset";
+        case LOG_INPUT:  return "input";
+        case LOG_APP:    return "app";
+        default:         return "log";
+    }
+}
+
+void write(int level, uint32_t category, const char* fmt, ...) {
+    // Errors and warnings go to stderr (console.error/warn in the browser)
+    FILE* out = level <= LOG_LEVEL_WARN ? stderr : stdout;
+
+    fprintf(out, "[%s] ", categoryName(category));
+
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(out, fmt, args);
+    va_end(args);
+}
+
+bool RateLimit::allow(double intervalMs, int& suppressedOut) {
+    double nowMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    if (nowMs - lastMs < intervalMs) {
+        suppressed++;
+        return false;
+    }
+
+    lastMs = nowMs;
+    suppressedOut = suppressed;
+    suppressed = 0;
+    return true;
+}
+
+}
@@ -0,0 +1,101 @@
+// Logger.h
+#pragma once
+#include <cstdint>
+
+// Compile-time log levels. Anything above LOG_LEVEL compiles to nothing,
+// arguments included. Release builds (NDEBUG) strip everything by default;
+// override with -DLOG_LEVEL=LOG_LEVEL_ERROR to keep errors.
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#ifdef NDEBUG
+#define LOG_LEVEL LOG_LEVEL_NONE
+#else
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+// Categories, filtered at compile time with -DLOG_CATEGORIES=(LOG_RENDER|LOG_ASSET)
+#define LOG_RENDER (1u << 0)
+#define LOG_ASSET  (1u << 1)
+#define LOG_INPUT  (1u << 2)
+#define LOG_APP    (1u << 3)
+#define LOG_ALL    0xFFFFFFFFu
+
+#ifndef LOG_CATEGORIES
+#define LOG_CATEGORIES LOG_ALL
+#endif
+
+namespace logger {
+
+void write(int level, uint32_t category, const char* fmt, ...)
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((format(printf, 3, 4)))
+#endif
+    ;
+
+// Per call site state for LOG_*_EVERY. Lets one message through per interval
+// and reports how many were dropped in between.
+struct RateLimit {
+    double lastMs = -1e30;
+    int suppressed = 0;
+
+    bool allow(double intervalMs, int& suppressedOut);
+};
+
+}
+
+#define LOG_CATEGORY_ENABLED(cat) ((LOG_CATEGORIES & (cat)) != 0)
+
+#define LOG_AT(level, cat, fmt, ...) \
+    do { if (LOG_CATEGORY_ENABLED(cat)) logger::write(level, cat, fmt, ##__VA_ARGS__); } while (0)
+
+// Rate-limited variant for per-frame diagnostics
+#define LOG_AT_EVERY(level, cat, intervalMs, fmt, ...)                          \
+    do {                                                                         \
+        if (LOG_CATEGORY_ENABLED(cat)) {                                         \
+            static logger::RateLimit logRateLimit_;                              \
+            int logSuppressed_ = 0;                                              \
+            if (logRateLimit_.allow(intervalMs, logSuppressed_)) {               \
+                logger::write(level, cat, fmt, ##__VA_ARGS__);                   \
+                if (logSuppressed_ > 0)                                          \
+                    logger::write(level, cat, "  (%d similar suppressed)\n", logSuppressed_); \
+            }                                                                    \
+        }                                                                        \
+    } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(cat, fmt, ...) LOG_AT(LOG_LEVEL_ERROR, cat, fmt, ##__VA_ARGS__)
+#define LOG_ERROR_EVERY(cat, ms, fmt, ...) LOG_AT_EVERY(LOG_LEVEL_ERROR, cat, ms, fmt, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(cat, fmt, ...) ((void)0)
+#define LOG_ERROR_EVERY(cat, ms, fmt, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(cat, fmt, ...) LOG_AT(LOG_LEVEL_WARN, cat, fmt, ##__VA_ARGS__)
+#define LOG_WARN_EVERY(cat, ms, fmt, ...) LOG_AT_EVERY(LOG_LEVEL_WARN, cat, ms, fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARN(cat, fmt, ...) ((void)0)
+#define LOG_WARN_EVERY(cat, ms, fmt, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(cat, fmt, ...) LOG_AT(LOG_LEVEL_INFO, cat, fmt, ##__VA_ARGS__)
+#define LOG_INFO_EVERY(cat, ms, fmt, ...) LOG_AT_EVERY(LOG_LEVEL_INFO, cat, ms, fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO(cat, fmt, ...) ((void)0)
+#define LOG_INFO_EVERY(cat, ms, fmt, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(cat, fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, cat, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG_EVERY(cat, ms, fmt, ...) LOG_AT_EVERY(LOG_LEVEL_DEBUG, cat, ms, fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(cat, fmt, ...) ((void)0)
+#define LOG_DEBUG_EVERY(cat, ms, fmt, ...) ((void)0)
+#endif
@@ -1,10 +1,12 @@
 #include "starship/starship.h"
 
-#include <emscripten.h>
-#include <emscripten/html5.h>
 #include <GLES3/gl3.h>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <cmath>
+#include <vector>
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -14,9 +16,34 @@
 #include "textRenderer/textRenderer.h"
 #include "button/button.h"
 #include "renderer2d/renderer2d.h"
+#include "renderQueue/renderQueue.h"
+#include "logger/logger.h"
+#include "profiler/profiler.h"
+#include "platform/platform.h"
+#include "glState/glState.h"
+#include "frameData/frameData.h"
+
+// One GPU scope per queue layer, so the single flush still times lines,
+// text and buttons apart. The overlay is not timed, as before.
+struct QueueLayerScopes : RenderQueue::Observer {
+    int scope = -1;
+
+    void beginLayer(uint32_t layer) override {
+        // By layer: LAYER_WORLD, LAYER_UI, LAYER_WIDGETS
+        static const char* const names[] = {"lines", "text", "buttons"};
+        scope = layer < RenderQueue::LAYER_OVERLAY ? profiler.beginScope(names[layer], true) : -1;
+    }
+    void endLayer(uint32_t) override {
+        profiler.endScope(scope);
+        scope = -1;
+    }
+};
 
+RenderQueue renderQueue;
+QueueLayerScopes queueLayerScopes;
 TextRenderer textRenderer;
 LineRenderer lineRenderer;
+LineRenderer::StaticLines debugLines[2] = {};
 Renderer2D renderer2d;
 ButtonManager buttonManager;
 float g_aspect = 0;
@@ -80,6 +107,8 @@ struct AppState {
     GLuint quadVBO = 0;
     
     float time = 0.0f;
+
+    bool showProfiler = false;
 };
 
 AppState app;
@@ -91,43 +120,47 @@ void browserToNormalized(float browserX, float browserY, float& outX, float& out
     outY = 1.0f - (browserY / app.height) * 2.0f;
 }
 
-EM_BOOL onMouseDown(int eventType, const EmscriptenMouseEvent* e, void* userData) {
+void onMouseDown(int button, float canvasX, float canvasY) {
     // Pixel coords for UI (Y flipped for OpenGL)
-    float pixelX = e->targetX;
-    float pixelY = app.height - e->targetY;
+    float pixelX = canvasX;
+    float pixelY = app.height - canvasY;
     
-    if (e->button == 0) {
+    if (button == 0) {
         buttonManager.fingerStart(pixelX, pixelY);
     }
     
     // Normalized coords for your ship
     float x, y;
-    browserToNormalized(e->targetX, e->targetY, x, y);
-    ship.onMouseDown(e->button, x, y);
-    
-    return EM_TRUE;
+    browserToNormalized(canvasX, canvasY, x, y);
+    ship.onMouseDown(button, x, y);
 }
 
-EM_BOOL onMouseUp(int eventType, const EmscriptenMouseEvent* e, void* userData) {
-    float pixelX = e->targetX;
-    float pixelY = app.height - e->targetY;
+void onMouseUp(int button, float canvasX, float canvasY) {
+    float pixelX = canvasX;
+    float pixelY = app.height - canvasY;
     
-    if (e->button == 0) {
+    if (button == 0) {
         buttonManager.fingerRelease(pixelX, pixelY);
     }
     
     float x, y;
-    browserToNormalized(e->targetX, e->targetY, x, y);
-    ship.onMouseUp(e->button, x, y);
-    
-    return EM_TRUE;
+    browserToNormalized(canvasX, canvasY, x, y);
+    ship.onMouseUp(button, x, y);
 }
 
-EM_BOOL onMouseMove(int eventType, const EmscriptenMouseEvent* e, void* userData) {
+void onMouseMove(int button, float canvasX, float canvasY) {
     float x, y;
-    browserToNormalized(e->targetX, e->targetY, x, y);
+    browserToNormalized(canvasX, canvasY, x, y);
     ship.onMouseMove(x, y);
-    return EM_TRUE;
+}
+
+bool onKeyDown(const char* key) {
+    // P toggles the profiler overlay
+    if (strcmp(key, "p") == 0 || strcmp(key, "P") == 0) {
+        app.showProfiler = !app.showProfiler;
+        return true;
+    }
+    return false;
 }
 
 GLuint compileShader(GLenum type, const char* source) {
@@ -140,7 +173,7 @@ GLuint compileShader(GLenum type, const char* source) {
     if (!success) {
         char infoLog[512];
         glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        printf("Shader compilation error: %s\n", infoLog);
+        LOG_ERROR(LOG_RENDER, "Shader compilation error: %s\n", infoLog);
     }
     return shader;
 }
@@ -159,7 +192,7 @@ GLuint createProgram(const char* vertSrc, const char* fragSrc) {
     if (!success) {
         char infoLog[512];
         glGetProgramInfoLog(program, 512, nullptr, infoLog);
-        printf("Program linking error: %s\n", infoLog);
+        LOG_ERROR(LOG_RENDER, "Program linking error: %s\n", infoLog);
     }
     
     glDeleteShader(vertShader);
@@ -184,13 +217,13 @@ void initFBO() {
     
     // Multisampled FBO
     glGenFramebuffers(1, &app.fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, app.fbo);
+    glState.bindFramebuffer(GL_FRAMEBUFFER, app.fbo);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, msaaRBO);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, app.rbo);
     
     // Regular texture for resolved output
     glGenTextures(1, &app.fboTexture);
-    glBindTexture(GL_TEXTURE_2D, app.fboTexture);
+    glState.bindTexture(0, app.fboTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, app.width, app.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -198,18 +231,18 @@ void initFBO() {
     // Resolve FBO (non-multisampled, for blitting to)
     GLuint resolveFBO;
     glGenFramebuffers(1, &resolveFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+    glState.bindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, app.fboTexture, 0);
     
     // Store for later
     app.resolveFBO = resolveFBO;
     app.msaaRBO = msaaRBO;
     
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void updateFBOTextureUV() {
-    glUseProgram(app.quadProgram);
+    glState.useProgram(app.quadProgram);
 
     float tileScale = 0.5;
     float tileWidth = 208.0 * tileScale;
@@ -235,8 +268,8 @@ void updateFBOTextureUV() {
          1.0f,  1.0f,    1.0f, 1.0f,   offsetX + tileCountX, offsetY + tileCountY  // Top Right
     };
     
-    glBindVertexArray(app.quadVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, app.quadVBO);
+    glState.bindVertexArray(app.quadVAO);
+    glState.bindBuffer(GL_ARRAY_BUFFER, app.quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
     /*    float imgWidth = 208;
@@ -254,27 +287,26 @@ void updateFBOTextureUV() {
     float tileWidth = width * multiplyFactor;*/
 }
 
-EM_BOOL onResize(int eventType, const EmscriptenUiEvent* e, void* userData) {
-    app.width = e->windowInnerWidth;
-    app.height = e->windowInnerHeight;
-    emscripten_set_canvas_element_size("#canvas", app.width, app.height);
-    glViewport(0, 0, app.width, app.height);
+void onResize(int width, int height) {
+    app.width = width;
+    app.height = height;
+    glState.viewport(0, 0, app.width, app.height);
     
     // Update projection matrix
     g_aspect = (float)app.width / (float)app.height;
     projection = glm::ortho(-g_aspect, g_aspect, -1.0f, 1.0f, -1.0f, 1.0f);
+    frameData.setProjection(projection);
+    frameData.setScreenSize((float)app.width, (float)app.height);
     
     // Recreate FBO at new size
-    if (app.fbo) glDeleteFramebuffers(1, &app.fbo);
-    if (app.fboTexture) glDeleteTextures(1, &app.fboTexture);
+    if (app.fbo) glState.deleteFramebuffer(app.fbo);
+    if (app.fboTexture) glState.deleteTexture(app.fboTexture);
     if (app.rbo) glDeleteRenderbuffers(1, &app.rbo);
-    if (app.resolveFBO) glDeleteFramebuffers(1, &app.resolveFBO);
+    if (app.resolveFBO) glState.deleteFramebuffer(app.resolveFBO);
     if (app.msaaRBO) glDeleteRenderbuffers(1, &app.msaaRBO);
     initFBO();
 
     updateFBOTextureUV();
-    
-    return EM_TRUE;
 }
 
 void initQuad() {
@@ -283,8 +315,8 @@ void initQuad() {
     glGenVertexArrays(1, &app.quadVAO);
     glGenBuffers(1, &app.quadVBO);
 
-    glBindVertexArray(app.quadVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, app.quadVBO);
+    glState.bindVertexArray(app.quadVAO);
+    glState.bindBuffer(GL_ARRAY_BUFFER, app.quadVBO);
     
     // Position attribute
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
@@ -298,7 +330,12 @@ void initQuad() {
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(4 * sizeof(float)));
     glEnableVertexAttribArray(2);
     
-    glBindVertexArray(0);
+    glState.bindVertexArray(0);
+
+    // Samplers never change units
+    glState.useProgram(app.quadProgram);
+    glUniform1i(glState.uniformLocation(app.quadProgram, "uSceneTexture"), 0);
+    glUniform1i(glState.uniformLocation(app.quadProgram, "uTileTexture"), 1);
 
     updateFBOTextureUV();
 }
@@ -306,63 +343,165 @@ void initQuad() {
 int f = 0;
 
 void renderToFBO() {
-    glBindFramebuffer(GL_FRAMEBUFFER, app.fbo);
-    glViewport(0, 0, app.width, app.height);
+    glState.bindFramebuffer(GL_FRAMEBUFFER, app.fbo);
+    glState.viewport(0, 0, app.width, app.height);
 
     // Clear with a dark color
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);  // alpha = 0
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    ship.drawGrid();
-    ship.drawCells();
-    ship.renderCannons();
-
-    lineRenderer.draw(glm::vec2(0.0, 0.0), glm::vec2(0.5, 0.5), glm::vec4(1.0, 1.0, 0.0, 1.0), 0.05);
-    lineRenderer.draw(glm::vec2(0.0, 0.0), glm::vec2(-0.5, 0.5), glm::vec4(1.0, 0.0, 0.0, 1.0), 0.02);
-    lineRenderer.flush(glm::value_ptr(projection), 0.0f);
-
+    {
+        PROFILE_GPU_SCOPE("grid");
+        ship.drawGrid();
+    }
+    {
+        PROFILE_GPU_SCOPE("cells");
+        ship.drawCells();
+    }
+    {
+        PROFILE_GPU_SCOPE("cannons");
+        ship.renderCannons();
+    }
+    // Lines, text, buttons and the profiler overlay all go through
+    // renderQueue, drawn layer by layer in one sorted pass
+    renderQueue.setLayer(RenderQueue::LAYER_WORLD);
+    lineRenderer.drawStatic(debugLines[0]);
+    lineRenderer.drawStatic(debugLines[1]);
+    lineRenderer.setRotation(0.0f);
+
+    renderQueue.setLayer(RenderQueue::LAYER_UI);
     textRenderer.draw("Hello World", 100.0f, 500.0f, 1.0f, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
     textRenderer.drawCentered("Centered Text", 640.0f, 360.0f, 0.5f, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
-    textRenderer.flush();
 
+    renderQueue.setLayer(RenderQueue::LAYER_WIDGETS);
     buttonManager.drawButtons();
 
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, app.fbo);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, app.resolveFBO);
-    glBlitFramebuffer(0, 0, app.width, app.height, 0, 0, app.width, app.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    if (app.showProfiler) {
+        renderQueue.setLayer(RenderQueue::LAYER_OVERLAY);
+        profiler.drawOverlay(textRenderer, 10.0f, app.height - 20.0f, 0.3f);
+    }
+
+    // Times each layer itself, see QueueLayerScopes
+    renderQueue.flush();
+
+    {
+        PROFILE_GPU_SCOPE("msaa resolve");
+        glState.bindFramebuffer(GL_READ_FRAMEBUFFER, app.fbo);
+        glState.bindFramebuffer(GL_DRAW_FRAMEBUFFER, app.resolveFBO);
+        glBlitFramebuffer(0, 0, app.width, app.height, 0, 0, app.width, app.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
     
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void renderToScreen() {
-    glViewport(0, 0, app.width, app.height);
+    PROFILE_GPU_SCOPE("composite");
+
+    glState.viewport(0, 0, app.width, app.height);
     
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
     
     // Draw fullscreen quad with FBO texture
-    glUseProgram(app.quadProgram);
-    glBindVertexArray(app.quadVAO);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, app.fboTexture);
-    glUniform1i(glGetUniformLocation(app.quadProgram, "uSceneTexture"), 0);
+    glState.useProgram(app.quadProgram);
+    glState.bindVertexArray(app.quadVAO);
 
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, backgroundTexture);
-    glUniform1i(glGetUniformLocation(app.quadProgram, "uTileTexture"), 1);
+    glState.bindTexture(0, app.fboTexture);
+    glState.bindTexture(1, backgroundTexture);
 
     glDrawArrays(GL_TRIANGLES, 0, 6);
 }
 
+// Command line options, only the native build gets any
+struct RunOptions {
+    int frames = 0;                    // stop after this many frames, 0 = run forever
+    bool benchmark = false;            // print per-frame timings and a summary
+    int grid = 0;                      // fill an N x N ship instead of the demo layout
+    const char* tracePath = nullptr;   // Chrome trace of every frame
+};
+
+static bool parseOptions(int argc, char** argv, RunOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--frames") == 0 && hasValue) {
+            options.frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--benchmark") == 0) {
+            options.benchmark = true;
+        } else if (strcmp(argv[i], "--grid") == 0 && hasValue) {
+            options.grid = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--size") == 0 && hasValue) {
+            if (sscanf(argv[++i], "%dx%d", &app.width, &app.height) != 2) return false;
+        } else if (strcmp(argv[i], "--trace") == 0 && hasValue) {
+            options.tracePath = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void printBenchmarkSummary(std::vector<double> times, const std::vector<int>& glCalls) {
+    if (times.empty()) return;
+
+    std::sort(times.begin(), times.end());
+    double sum = 0.0;
+    for (double t : times) sum += t;
+
+    auto percentile = [&](double p) {
+        size_t index = (size_t)std::ceil(p * times.size());
+        return times[std::min(times.size() - 1, index > 0 ? index - 1 : 0)];
+    };
+
+    double avg = sum / times.size();
+    printf("frames %zu | min %.3f | avg %.3f | p50 %.3f | p99 %.3f | max %.3f ms | %.1f fps\n",
+           times.size(), times.front(), avg, percentile(0.50), percentile(0.99), times.back(), 1000.0 / avg);
+
+    long long totalCalls = 0;
+    for (int calls : glCalls) totalCalls += calls;
+    if (!glCalls.empty()) {
+        printf("gl calls/frame avg %.1f\n", (double)totalCalls / glCalls.size());
+    }
+}
+
+RunOptions options;
+std::vector<double> frameTimes;
+std::vector<int> frameGLCalls;
+int frameIndex = 0;
+
 void mainLoop() {
+    double frameStart = platform::nowMs();
     app.time += 0.016f;
+
+    glState.beginFrame();
+    profiler.beginFrame();
+
+    // Shared per-frame uniforms, only the changed bytes are uploaded
+    frameData.setShipRotation(ship.currentRotation);
+    frameData.setTime(platform::nowMs() / 1000.0f);
+    frameData.upload();
     
     // Render triangle to FBO
     renderToFBO();
     
     // Display FBO on screen
     renderToScreen();
+
+    profiler.endFrame();
+
+    if (options.benchmark) {
+        // Wait for the GPU so each sample covers the whole frame
+        glFinish();
+        double frameMs = platform::nowMs() - frameStart;
+        frameTimes.push_back(frameMs);
+        frameGLCalls.push_back(glState.callsThisFrame());
+        printf("frame %5d %8.3f ms  gl calls %5d  skipped %5d\n",
+               frameIndex, frameMs, glState.callsThisFrame(), glState.skippedThisFrame());
+    }
+
+    frameIndex++;
+    if (options.frames > 0 && frameIndex >= options.frames) {
+        platform::requestQuit();
+    }
 }
 
 GLuint static loadTexture(const char* path) {
@@ -370,13 +509,13 @@ GLuint static loadTexture(const char* path) {
     unsigned char* data = stbi_load(path, &width, &height, &channels, 4);  // force RGBA
     
     if(!data) {
-        printf("Failed to load texture: %s\n", path);
+        LOG_ERROR(LOG_ASSET, "Failed to load texture: %s\n", path);
         return 0;
     }
     
     GLuint texture;
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    glState.bindTexture(0, texture);
     
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
     
@@ -387,79 +526,80 @@ GLuint static loadTexture(const char* path) {
     
     stbi_image_free(data);
     
-    printf("Loaded texture: %s (%dx%d)\n", path, width, height);
+    LOG_INFO(LOG_ASSET, "Loaded texture: %s (%dx%d)\n", path, width, height);
     return texture;
 }
 
 
-int main() {
-    // Set size FIRST
-    app.width = EM_ASM_INT({ 
-        var canvas = document.getElementById('canvas');
-        canvas.width = canvas.clientWidth;
-        canvas.height = canvas.clientHeight;
-        return canvas.width;
-    });
-    app.height = EM_ASM_INT({ 
-        return document.getElementById('canvas').height;
-    });
-    emscripten_set_canvas_element_size("#canvas", app.width, app.height);
-    emscripten_set_resize_callback(EMSCRIPTEN_EVENT_TARGET_WINDOW, nullptr, EM_TRUE, onResize);
+int main(int argc, char** argv) {
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [--frames N] [--benchmark] [--grid N] [--size WxH] [--trace file.json]\n", argv[0]);
+        return 1;
+    }
+
+    // Context first, on the web the canvas decides the size
+    if (!platform::createContext(app.width, app.height)) {
+        return -1;
+    }
+    platform::setResizeHandler(onResize);
 
     // Orthographic projection that corrects aspect ratio
     // This maps (-aspect, -1) to (aspect, 1) in world space to (-1, -1) to (1, 1) in clip space
     g_aspect = (float)app.width / (float)app.height;
     projection = glm::ortho(-g_aspect, g_aspect, -1.0f, 1.0f, -1.0f, 1.0f);
-g_aspect = (float)app.width / (float)app.height;
-    // Create WebGL2 context
-    EmscriptenWebGLContextAttributes attrs;
-    emscripten_webgl_init_context_attributes(&attrs);
-    attrs.majorVersion = 2;
-    attrs.minorVersion = 0;
-    attrs.alpha = false;
-    attrs.depth = true;
-    attrs.stencil = false;
-    attrs.antialias = true;
-    attrs.premultipliedAlpha = true;
-    attrs.preserveDrawingBuffer = false;
-    
-    EMSCRIPTEN_WEBGL_CONTEXT_HANDLE ctx = emscripten_webgl_create_context("#canvas", &attrs);
-    if (ctx <= 0) {
-        printf("Failed to create WebGL2 context\n");
-        return -1;
-    }
-    emscripten_webgl_make_context_current(ctx);
-    
-    printf("WebGL2 context created successfully\n");
-    printf("GL_VERSION: %s\n", glGetString(GL_VERSION));
-    printf("GL_RENDERER: %s\n", glGetString(GL_RENDERER));
+
+    LOG_INFO(LOG_RENDER, "GL_VERSION: %s\n", glGetString(GL_VERSION));
+    LOG_INFO(LOG_RENDER, "GL_RENDERER: %s\n", glGetString(GL_RENDERER));
     
+    profiler.init();
+
+    frameData.init();
+    frameData.setProjection(projection);
+    frameData.setScreenSize((float)app.width, (float)app.height);
+
     backgroundTexture = loadTexture("background_tile.png");
 
     // Initialize resources
     initFBO();
     initQuad();
     
-    printf("Initialization complete. Starting render loop...\n");
-    
-    // prevent right click from popping pop up
-    EM_ASM({
-    document.getElementById('canvas').addEventListener('contextmenu', function(e) {
-        e.preventDefault();
-        });
-    });
+    LOG_INFO(LOG_APP, "Initialization complete. Starting render loop...\n");
 
     ship.setAspect((float)app.width / (float)app.height);
     ship.initStarshipCells();
     ship.initCellMiddlePoints();
+    if (options.grid > 0) {
+        ship.setGridSize(options.grid, options.grid);
+    }
     ship.initGrid();
     ship.initCellRendering();
     lineRenderer.init();
-    textRenderer.initialize("fonts/Roboto-Medium.ttf", (float)app.width, (float)app.height);
+    // The debug lines never change, their segments are uploaded once
+    LineRenderer::Style debugStyle;
+    debugStyle.color = glm::vec4(1.0f, 1.0f, 0.0f, 1.0f);
+    debugStyle.thickness = 0.05f;
+    debugLines[0] = lineRenderer.createStaticLines({glm::vec2(0.0f, 0.0f), glm::vec2(0.5f, 0.5f)}, debugStyle);
+    debugStyle.color = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+    debugStyle.thickness = 0.02f;
+    debugLines[1] = lineRenderer.createStaticLines({glm::vec2(0.0f, 0.0f), glm::vec2(-0.5f, 0.5f)}, debugStyle);
+    // Baked atlas first; the TTF only loads when FreeType is built in
+    if (!textRenderer.initialize("fonts/Roboto-Medium.font", app.width, app.height)) {
+        textRenderer.initialize("fonts/Roboto-Medium.ttf", app.width, app.height);
+    }
+#ifndef TEXT_RENDERER_NO_FREETYPE
+    // Anything beyond the baked ASCII set comes from the TTF
+    textRenderer.setDynamicFont("fonts/Roboto-Medium.ttf");
+#endif
     
     renderer2d.init();
     renderer2d.setScreenSize( (float)app.width, (float)app.height);
-    buttonManager.init(&textRenderer, &renderer2d);
+    buttonManager.init(&textRenderer, &renderer2d, &renderQueue);
+
+    // Registration order is draw order within a pass: rects, sprites, text, lines
+    renderer2d.setRenderQueue(&renderQueue);
+    textRenderer.setRenderQueue(&renderQueue);
+    lineRenderer.setRenderQueue(&renderQueue);
+    renderQueue.setObserver(&queueLayerScopes);
 
     // Create button
     Button config;
@@ -504,32 +644,56 @@ g_aspect = (float)app.width / (float)app.height;
     ship.newAttackCell(Starship::CELL_RADIOACTIVE, 27);
     ship.newAttackCell(Starship::CELL_RADIOACTIVE, 28);*/
 
-    for(int i = 29; i < 34; ++i) {
-            ship.newAttackCell(Starship::CELL_FIRE, i);
-    }
+    ship.beginEdit();
 
-    for(int i = 55; i < 60; ++i) {
-            ship.newAttackCell(Starship::CELL_FIRE, i);
-    }
+    if (options.grid > 0) {
+        // Every cell alive, worst case for the cell and cannon passes
+        const Starship::CellName names[] = { Starship::CELL_FIRE, Starship::CELL_ICE, Starship::CELL_RADIOACTIVE };
+        for (int i = 1; i <= ship.cells.size(); ++i) {
+            ship.newAttackCell(names[i % 3], i);
+        }
+    } else {
+        for(int i = 29; i < 34; ++i) {
+                ship.newAttackCell(Starship::CELL_FIRE, i);
+        }
 
-    for(int i = 60; i < 104; ++i) {
-            ship.newAttackCell(Starship::CELL_FIRE, i);
-    }
+        for(int i = 55; i < 60; ++i) {
+                ship.newAttackCell(Starship::CELL_FIRE, i);
+        }
 
-    for(int i = 139; i < 164; ++i) {
-            ship.newAttackCell(Starship::CELL_RADIOACTIVE, i);
+        for(int i = 60; i < 104; ++i) {
+                ship.newAttackCell(Starship::CELL_FIRE, i);
+        }
+
+        for(int i = 139; i < 164; ++i) {
+                ship.newAttackCell(Starship::CELL_RADIOACTIVE, i);
+        }
     }
 
+    ship.commitEdits();
+
     ship.initCannons();
 
 
-    // Register mouse events
-    emscripten_set_mousedown_callback("#canvas", nullptr, EM_TRUE, onMouseDown);
-    emscripten_set_mouseup_callback("#canvas", nullptr, EM_TRUE, onMouseUp);
-    emscripten_set_mousemove_callback("#canvas", nullptr, EM_TRUE, onMouseMove);
+    platform::setMouseDownHandler(onMouseDown);
+    platform::setMouseUpHandler(onMouseUp);
+    platform::setMouseMoveHandler(onMouseMove);
+    platform::setKeyDownHandler(onKeyDown);
 
-    // Start main loop
-    emscripten_set_main_loop(mainLoop, 0, 1);
+    if (options.tracePath) {
+        profiler.startCapture(options.frames > 0 ? options.frames : 300);
+    }
+
+    // Start main loop, only returns on native builds
+    platform::runMainLoop(mainLoop);
+
+    if (options.benchmark) {
+        printBenchmarkSummary(frameTimes, frameGLCalls);
+    }
+    if (options.tracePath) {
+        profiler.exportChromeTrace(options.tracePath);
+    }
+    platform::destroyContext();
     
     return 0;
 }
@@ -0,0 +1,36 @@
+// Platform.h
+#pragma once
+
+// Thin layer over everything the app needs from its host: GL context
+// creation, the frame loop, input and time. platform_web.cpp implements it
+// on top of Emscripten/HTML5, platform_native.cpp on a headless EGL context
+// (Mesa surfaceless / llvmpipe) for benchmarking on machines without a GPU.
+namespace platform {
+
+    // Pixel coordinates relative to the canvas, origin at the top left
+    using MouseHandler = void (*)(int button, float x, float y);
+    // Returns true when the key was handled
+    using KeyHandler = bool (*)(const char* key);
+    using ResizeHandler = void (*)(int width, int height);
+    using FrameHandler = void (*)();
+
+    // Creates a GLES3 / WebGL2 context and makes it current. On the web the
+    // canvas decides the size and width/height are overwritten; natively they
+    // are the size of the offscreen surface.
+    bool createContext(int& width, int& height);
+    void destroyContext();
+
+    // Milliseconds since startup (page load on the web), monotonic
+    double nowMs();
+
+    void setMouseDownHandler(MouseHandler handler);
+    void setMouseUpHandler(MouseHandler handler);
+    void setMouseMoveHandler(MouseHandler handler);
+    void setKeyDownHandler(KeyHandler handler);
+    void setResizeHandler(ResizeHandler handler);
+
+    // Calls frame() once per display refresh on the web. Natively it runs
+    // back to back until requestQuit() and then returns.
+    void runMainLoop(FrameHandler frame);
+    void requestQuit();
+}
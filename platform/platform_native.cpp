@@ -0,0 +1,116 @@
+// platform_native.cpp
+#include "platform.h"
+#include "logger/logger.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+#include <chrono>
+
+// Headless GLES3 through EGL. Prefers Mesa's surfaceless platform so no X or
+// Wayland server is needed; rendering goes to a pbuffer the size of the
+// requested canvas. There is no window, so input and resize never fire.
+namespace platform {
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLContext context = EGL_NO_CONTEXT;
+static EGLSurface surface = EGL_NO_SURFACE;
+static bool quitRequested = false;
+
+static EGLDisplay openDisplay() {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) {
+        EGLDisplay surfaceless = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (surfaceless != EGL_NO_DISPLAY) return surfaceless;
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+bool createContext(int& width, int& height) {
+    display = openDisplay();
+    EGLint major = 0, minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        LOG_ERROR(LOG_RENDER, "Failed to initialize EGL display\n");
+        return false;
+    }
+    eglBindAPI(EGL_OPENGL_ES_API);
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_DEPTH_SIZE, 16,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    eglChooseConfig(display, configAttribs, &config, 1, &configCount);
+
+    const EGLint contextAttribs[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 0, EGL_NONE };
+    context = eglCreateContext(display, configCount > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        LOG_ERROR(LOG_RENDER, "Failed to create GLES3 context (EGL error 0x%x)\n", eglGetError());
+        return false;
+    }
+
+    if (configCount > 0) {
+        const EGLint surfaceAttribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+        surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+    }
+    if (surface == EGL_NO_SURFACE) {
+        // Still usable, everything but the final composite goes to FBOs
+        LOG_WARN(LOG_RENDER, "No pbuffer surface, rendering without a default framebuffer\n");
+    }
+
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        LOG_ERROR(LOG_RENDER, "eglMakeCurrent failed (EGL error 0x%x)\n", eglGetError());
+        return false;
+    }
+
+    LOG_INFO(LOG_RENDER, "Headless EGL %d.%d context created (%dx%d)\n", major, minor, width, height);
+    return true;
+}
+
+void destroyContext() {
+    if (display == EGL_NO_DISPLAY) return;
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+    if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+    eglTerminate(display);
+
+    display = EGL_NO_DISPLAY;
+    context = EGL_NO_CONTEXT;
+    surface = EGL_NO_SURFACE;
+}
+
+// steady_clock counts from boot on Linux; callers keep float seconds, so
+// count from startup like emscripten_get_now() does from page load
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+double nowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void setMouseDownHandler(MouseHandler) {}
+void setMouseUpHandler(MouseHandler) {}
+void setMouseMoveHandler(MouseHandler) {}
+void setKeyDownHandler(KeyHandler) {}
+void setResizeHandler(ResizeHandler) {}
+
+void runMainLoop(FrameHandler frame) {
+    quitRequested = false;
+    while (!quitRequested) {
+        frame();
+        if (surface != EGL_NO_SURFACE) eglSwapBuffers(display, surface);
+    }
+}
+
+void requestQuit() {
+    quitRequested = true;
+}
+
+}
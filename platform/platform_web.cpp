@@ -0,0 +1,116 @@
+// platform_web.cpp
+#include "platform.h"
+#include "logger/logger.h"
+
+#include <emscripten.h>
+#include <emscripten/html5.h>
+
+namespace platform {
+
+static MouseHandler mouseDownHandler = nullptr;
+static MouseHandler mouseUpHandler = nullptr;
+static MouseHandler mouseMoveHandler = nullptr;
+static KeyHandler keyDownHandler = nullptr;
+static ResizeHandler resizeHandler = nullptr;
+
+static EMSCRIPTEN_WEBGL_CONTEXT_HANDLE context = 0;
+
+static EM_BOOL onMouseDown(int eventType, const EmscriptenMouseEvent* e, void* userData) {
+    if (mouseDownHandler) mouseDownHandler(e->button, (float)e->targetX, (float)e->targetY);
+    return EM_TRUE;
+}
+
+static EM_BOOL onMouseUp(int eventType, const EmscriptenMouseEvent* e, void* userData) {
+    if (mouseUpHandler) mouseUpHandler(e->button, (float)e->targetX, (float)e->targetY);
+    return EM_TRUE;
+}
+
+static EM_BOOL onMouseMove(int eventType, const EmscriptenMouseEvent* e, void* userData) {
+    if (mouseMoveHandler) mouseMoveHandler(e->button, (float)e->targetX, (float)e->targetY);
+    return EM_TRUE;
+}
+
+static EM_BOOL onKeyDown(int eventType, const EmscriptenKeyboardEvent* e, void* userData) {
+    return keyDownHandler && keyDownHandler(e->key) ? EM_TRUE : EM_FALSE;
+}
+
+static EM_BOOL onResize(int eventType, const EmscriptenUiEvent* e, void* userData) {
+    emscripten_set_canvas_element_size("#canvas", e->windowInnerWidth, e->windowInnerHeight);
+    if (resizeHandler) resizeHandler(e->windowInnerWidth, e->windowInnerHeight);
+    return EM_TRUE;
+}
+
+bool createContext(int& width, int& height) {
+    // Match the canvas backing store to its CSS size
+    width = EM_ASM_INT({
+        var canvas = document.getElementById('canvas');
+        canvas.width = canvas.clientWidth;
+        canvas.height = canvas.clientHeight;
+        return canvas.width;
+    });
+    height = EM_ASM_INT({
+        return document.getElementById('canvas').height;
+    });
+    emscripten_set_canvas_element_size("#canvas", width, height);
+
+    EmscriptenWebGLContextAttributes attrs;
+    emscripten_webgl_init_context_attributes(&attrs);
+    attrs.majorVersion = 2;
+    attrs.minorVersion = 0;
+    attrs.alpha = false;
+    attrs.depth = true;
+    attrs.stencil = false;
+    attrs.antialias = true;
+    attrs.premultipliedAlpha = true;
+    attrs.preserveDrawingBuffer = false;
+
+    context = emscripten_webgl_create_context("#canvas", &attrs);
+    if (context <= 0) {
+        LOG_ERROR(LOG_RENDER, "Failed to create WebGL2 context\n");
+        return false;
+    }
+    emscripten_webgl_make_context_current(context);
+
+    // prevent right click from popping pop up
+    EM_ASM({
+        document.getElementById('canvas').addEventListener('contextmenu', function(e) {
+            e.preventDefault();
+        });
+    });
+
+    emscripten_set_mousedown_callback("#canvas", nullptr, EM_TRUE, onMouseDown);
+    emscripten_set_mouseup_callback("#canvas", nullptr, EM_TRUE, onMouseUp);
+    emscripten_set_mousemove_callback("#canvas", nullptr, EM_TRUE, onMouseMove);
+    emscripten_set_keydown_callback(EMSCRIPTEN_EVENT_TARGET_WINDOW, nullptr, EM_TRUE, onKeyDown);
+    emscripten_set_resize_callback(EMSCRIPTEN_EVENT_TARGET_WINDOW, nullptr, EM_TRUE, onResize);
+
+    LOG_INFO(LOG_RENDER, "WebGL2 context created successfully\n");
+    return true;
+}
+
+void destroyContext() {
+    if (context > 0) {
+        emscripten_webgl_destroy_context(context);
+        context = 0;
+    }
+}
+
+double nowMs() {
+    return emscripten_get_now();
+}
+
+void setMouseDownHandler(MouseHandler handler) { mouseDownHandler = handler; }
+void setMouseUpHandler(MouseHandler handler) { mouseUpHandler = handler; }
+void setMouseMoveHandler(MouseHandler handler) { mouseMoveHandler = handler; }
+void setKeyDownHandler(KeyHandler handler) { keyDownHandler = handler; }
+void setResizeHandler(ResizeHandler handler) { resizeHandler = handler; }
+
+void runMainLoop(FrameHandler frame) {
+    emscripten_set_main_loop(frame, 0, 1);
+}
+
+void requestQuit() {
+    emscripten_cancel_main_loop();
+}
+
+}
@@ -0,0 +1,309 @@
+// Profiler.cpp
+#include "profiler.h"
+#include "textRenderer/textRenderer.h"
+#include "logger/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// EXT_disjoint_timer_query / EXT_disjoint_timer_query_webgl2
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+Profiler profiler;
+
+void Profiler::History::push(float value) {
+    samples[next] = value;
+    next = (next + 1) % HISTORY;
+    if (count < HISTORY) count++;
+}
+
+void Profiler::History::stats(float& minOut, float& avgOut, float& p99Out) const {
+    if (count == 0) {
+        minOut = avgOut = p99Out = 0.0f;
+        return;
+    }
+
+    float sorted[HISTORY];
+    float sum = 0.0f;
+    minOut = samples[0];
+    for (int i = 0; i < count; i++) {
+        sorted[i] = samples[i];
+        sum += samples[i];
+        minOut = std::min(minOut, samples[i]);
+    }
+    avgOut = sum / count;
+
+    int p99Index = std::max(0, (int)std::ceil(0.99f * count) - 1);
+    std::nth_element(sorted, sorted + p99Index, sorted + count);
+    p99Out = sorted[p99Index];
+}
+
+void Profiler::init() {
+    gpuTimersSupported = false;
+
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount; i++) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        // Native GLES reports EXT_disjoint_timer_query, WebGL2 the _webgl2 variant
+        if (extension && strstr(extension, "disjoint_timer_query")) {
+            gpuTimersSupported = true;
+            break;
+        }
+    }
+
+    LOG_INFO(LOG_RENDER, "Profiler: GPU timer queries %s\n", gpuTimersSupported ? "available" : "not available");
+}
+
+double Profiler::nowUs() const {
+    return std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int Profiler::findOrAddScope(const char* name, int parent) {
+    for (size_t i = 0; i < scopes.size(); i++) {
+        if (scopes[i].parent == parent && (scopes[i].name == name || strcmp(scopes[i].name, name) == 0)) {
+            return (int)i;
+        }
+    }
+
+    Scope scope;
+    scope.name = name;
+    scope.parent = parent;
+    scope.depth = parent < 0 ? 0 : scopes[parent].depth + 1;
+    scopes.push_back(scope);
+    return (int)scopes.size() - 1;
+}
+
+GLuint Profiler::acquireQuery() {
+    if (!freeQueries.empty()) {
+        GLuint query = freeQueries.back();
+        freeQueries.pop_back();
+        return query;
+    }
+
+    GLuint query = 0;
+    glGenQueries(1, &query);
+    return query;
+}
+
+void Profiler::resolveQueries() {
+    if (pending.empty()) return;
+
+    // A disjoint event (GPU reset, frequency change) invalidates in-flight results
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+    size_t resolved = 0;
+    for (; resolved < pending.size(); resolved++) {
+        const PendingQuery& entry = pending[resolved];
+
+        // Queries complete in order, stop at the first one still in flight
+        GLuint available = 0;
+        glGetQueryObjectuiv(entry.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+
+        GLuint elapsedNs = 0;
+        glGetQueryObjectuiv(entry.query, GL_QUERY_RESULT, &elapsedNs);
+
+        if (!disjoint) {
+            scopes[entry.scope].gpu.push(elapsedNs / 1.0e6f);
+            if (entry.traceEvent >= 0) {
+                traceEvents[entry.traceEvent].gpuUs = elapsedNs / 1000.0;
+            }
+        }
+        freeQueries.push_back(entry.query);
+    }
+
+    pending.erase(pending.begin(), pending.begin() + resolved);
+}
+
+void Profiler::beginFrame() {
+    if (!enabled) return;
+
+    resolveQueries();
+
+    stack.clear();
+    for (auto& scope : scopes) {
+        scope.frameCpuMs = 0.0;
+        scope.touched = false;
+    }
+
+    beginScope("frame", false);
+}
+
+void Profiler::endFrame() {
+    if (!enabled || stack.empty()) return;
+
+    // Close the implicit "frame" scope and anything left open
+    while (!stack.empty()) {
+        endScope(stack.back().scope);
+    }
+
+    for (auto& scope : scopes) {
+        if (scope.touched) {
+            scope.cpu.push((float)scope.frameCpuMs);
+        }
+    }
+
+    if (captureFramesLeft > 0) {
+        captureFramesLeft--;
+        if (captureFramesLeft == 0) {
+            LOG_INFO(LOG_APP, "Profiler: captured %zu trace events\n", traceEvents.size());
+        }
+    }
+}
+
+int Profiler::beginScope(const char* name, bool gpu) {
+    if (!enabled) return -1;
+
+    int parent = stack.empty() ? -1 : stack.back().scope;
+    int index = findOrAddScope(name, parent);
+
+    OpenScope open;
+    open.scope = index;
+    open.startUs = nowUs();
+    open.query = 0;
+    open.traceEvent = -1;
+
+    // TIME_ELAPSED queries cannot nest, inner GPU scopes are CPU-only
+    if (gpu && gpuTimersSupported && !gpuQueryActive) {
+        open.query = acquireQuery();
+        glBeginQuery(GL_TIME_ELAPSED_EXT, open.query);
+        gpuQueryActive = true;
+        scopes[index].hasGpu = true;
+    }
+
+    if (captureFramesLeft > 0) {
+        open.traceEvent = (int)traceEvents.size();
+        traceEvents.push_back({index, open.startUs, 0.0, -1.0});
+    }
+
+    stack.push_back(open);
+    return index;
+}
+
+void Profiler::endScope(int scope) {
+    if (scope < 0 || stack.empty()) return;
+
+    OpenScope open = stack.back();
+    stack.pop_back();
+
+    double elapsedUs = nowUs() - open.startUs;
+    scopes[open.scope].frameCpuMs += elapsedUs / 1000.0;
+    scopes[open.scope].touched = true;
+
+    if (open.query != 0) {
+        glEndQuery(GL_TIME_ELAPSED_EXT);
+        gpuQueryActive = false;
+        pending.push_back({open.query, open.scope, open.traceEvent});
+    }
+
+    if (open.traceEvent >= 0) {
+        traceEvents[open.traceEvent].cpuUs = elapsedUs;
+    }
+}
+
+const std::vector<Profiler::ScopeStats>& Profiler::computeStats() {
+    statsCache.clear();
+
+    // Depth-first so children follow their parent
+    std::vector<int> order;
+    order.reserve(scopes.size());
+    std::vector<int> todo;
+    for (int i = (int)scopes.size() - 1; i >= 0; i--) {
+        if (scopes[i].parent < 0) todo.push_back(i);
+    }
+    while (!todo.empty()) {
+        int current = todo.back();
+        todo.pop_back();
+        order.push_back(current);
+        for (int i = (int)scopes.size() - 1; i >= 0; i--) {
+            if (scopes[i].parent == current) todo.push_back(i);
+        }
+    }
+
+    for (int index : order) {
+        const Scope& scope = scopes[index];
+        ScopeStats stats;
+        stats.name = scope.name;
+        stats.depth = scope.depth;
+        stats.hasGpu = scope.hasGpu;
+        scope.cpu.stats(stats.cpuMin, stats.cpuAvg, stats.cpuP99);
+        scope.gpu.stats(stats.gpuMin, stats.gpuAvg, stats.gpuP99);
+        statsCache.push_back(stats);
+    }
+
+    return statsCache;
+}
+
+void Profiler::drawOverlay(TextRenderer& textRenderer, float x, float y, float scale) {
+    const auto& stats = computeStats();
+
+    float lineHeight = 52.0f * scale;
+    glm::vec4 headerColor(1.0f, 1.0f, 0.4f, 1.0f);
+    glm::vec4 textColor(1.0f, 1.0f, 1.0f, 0.9f);
+
+    textRenderer.draw("scope            cpu min/avg/p99 ms     gpu min/avg/p99 ms", x, y, scale, headerColor);
+    y -= lineHeight;
+
+    char line[160];
+    for (const auto& s : stats) {
+        int written = snprintf(line, sizeof(line), "%*s%-*s %6.2f %6.2f %6.2f",
+                               s.depth * 2, "", 16 - s.depth * 2, s.name,
+                               s.cpuMin, s.cpuAvg, s.cpuP99);
+        if (s.hasGpu && written > 0 && written < (int)sizeof(line)) {
+            snprintf(line + written, sizeof(line) - written, "    %6.2f %6.2f %6.2f",
+                     s.gpuMin, s.gpuAvg, s.gpuP99);
+        }
+        textRenderer.draw(line, x, y, scale, textColor);
+        y -= lineHeight;
+    }
+}
+
+void Profiler::startCapture(int frames) {
+    // Queries in flight and open scopes point into the old capture
+    for (PendingQuery& entry : pending) entry.traceEvent = -1;
+    for (OpenScope& open : stack) open.traceEvent = -1;
+    traceEvents.clear();
+    captureFramesLeft = frames;
+}
+
+bool Profiler::exportChromeTrace(const char* path) const {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        LOG_ERROR(LOG_APP, "Profiler: cannot write trace to %s\n", path);
+        return false;
+    }
+
+    // Chrome trace event format, load in chrome://tracing or ui.perfetto.dev
+    fprintf(file, "{\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+
+    double origin = traceEvents.empty() ? 0.0 : traceEvents.front().startUs;
+    for (const auto& event : traceEvents) {
+        const char* name = scopes[event.scope].name;
+        fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}",
+                name, event.startUs - origin, event.cpuUs);
+
+        // GPU durations have no timestamp of their own, align them with the CPU scope
+        if (event.gpuUs >= 0.0) {
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"gpu\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":2}",
+                    name, event.startUs - origin, event.gpuUs);
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    LOG_INFO(LOG_APP, "Profiler: wrote %zu events to %s\n", traceEvents.size(), path);
+    return true;
+}
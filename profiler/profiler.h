@@ -0,0 +1,121 @@
+// Profiler.h
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GLES3/gl3.h>
+
+class TextRenderer;
+
+// Hierarchical frame profiler. CPU scopes use a steady clock; GPU scopes use
+// EXT_disjoint_timer_query(_webgl2) when the context exposes it. Results are
+// kept over a rolling window of frames per scope.
+class Profiler {
+public:
+    static const int HISTORY = 128;   // frames kept per scope
+
+    struct ScopeStats {
+        const char* name;
+        int depth;
+        float cpuMin, cpuAvg, cpuP99;   // milliseconds
+        float gpuMin, gpuAvg, gpuP99;
+        bool hasGpu;
+    };
+
+    void init();
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    bool isEnabled() const { return enabled; }
+    bool hasGpuTimers() const { return gpuTimersSupported; }
+
+    void beginFrame();
+    void endFrame();
+
+    int beginScope(const char* name, bool gpu);
+    void endScope(int scope);
+
+    // Rolling min/avg/p99 for every scope, in tree order
+    const std::vector<ScopeStats>& computeStats();
+
+    void drawOverlay(TextRenderer& textRenderer, float x, float y, float scale);
+
+    // Records every scope of the next `frames` frames for exportChromeTrace
+    void startCapture(int frames);
+    bool isCapturing() const { return captureFramesLeft > 0; }
+    bool exportChromeTrace(const char* path) const;
+
+private:
+    struct History {
+        float samples[HISTORY];
+        int count = 0;
+        int next = 0;
+
+        void push(float value);
+        void stats(float& minOut, float& avgOut, float& p99Out) const;
+    };
+
+    struct Scope {
+        const char* name;
+        int parent;
+        int depth;
+        History cpu;
+        History gpu;
+        bool hasGpu = false;
+        double frameCpuMs = 0.0;   // accumulated this frame
+        bool touched = false;
+    };
+
+    struct OpenScope {
+        int scope;
+        double startUs;
+        GLuint query;      // 0 when this scope has no GPU query
+        int traceEvent;    // -1 when not capturing
+    };
+
+    struct PendingQuery {
+        GLuint query;
+        int scope;
+        int traceEvent;
+    };
+
+    struct TraceEvent {
+        int scope;
+        double startUs;
+        double cpuUs;
+        double gpuUs;      // < 0 until the query resolves
+    };
+
+    double nowUs() const;
+    int findOrAddScope(const char* name, int parent);
+    GLuint acquireQuery();
+    void resolveQueries();
+
+    bool enabled = true;
+    bool gpuTimersSupported = false;
+    bool gpuQueryActive = false;
+
+    std::vector<Scope> scopes;
+    std::vector<OpenScope> stack;
+    std::vector<PendingQuery> pending;
+    std::vector<GLuint> freeQueries;
+    std::vector<ScopeStats> statsCache;
+
+    int captureFramesLeft = 0;
+    std::vector<TraceEvent> traceEvents;
+};
+
+extern Profiler profiler;
+
+// RAII scope, prefer the PROFILE_* macros below
+class ProfileScope {
+public:
+    ProfileScope(const char* name, bool gpu) : scope(profiler.beginScope(name, gpu)) {}
+    ~ProfileScope() { profiler.endScope(scope); }
+
+private:
+    int scope;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name, false)
+#define PROFILE_GPU_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name, true)
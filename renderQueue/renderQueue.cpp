@@ -0,0 +1,99 @@
+// RenderQueue.cpp
+#include "renderQueue.h"
+#include <algorithm>
+#include "logger/logger.h"
+
+static const int KEY_BYTES = 8;
+static const int STATE_SHIFT = 32;     // key bits above the depth
+static const int LAYER_SHIFT = 28;     // of the state
+
+uint32_t RenderQueue::registerShader(RenderBackend* backend) {
+    if (shaders.size() >= 256) {
+        LOG_ERROR(LOG_RENDER, "RenderQueue: out of shader ids\n");
+        return 255;
+    }
+    shaders.push_back(backend);
+    if (std::find(backends.begin(), backends.end(), backend) == backends.end()) {
+        backends.push_back(backend);
+    }
+    return static_cast<uint32_t>(shaders.size() - 1);
+}
+
+void RenderQueue::setLayer(uint32_t layer, uint32_t pass) {
+    this->layer = layer & 0xF;
+    this->pass = pass & 0xF;
+    prefix = (uint64_t)this->layer << 60 | (uint64_t)this->pass << 56;
+}
+
+void RenderQueue::setPass(uint32_t pass) {
+    setLayer(layer, pass);
+}
+
+// LSD radix sort, a byte per pass, stable. All byte histograms come from
+// one read of the keys; bytes every key shares are skipped, which for a
+// typical frame is most of the depth and all of the texture bits.
+void RenderQueue::sort() {
+    size_t count = entries.size();
+    if (count < 2) return;
+
+    uint32_t histogram[KEY_BYTES][256] = {};
+    for (const Entry& entry : entries) {
+        for (int b = 0; b < KEY_BYTES; b++) {
+            histogram[b][(entry.key >> (b * 8)) & 0xFF]++;
+        }
+    }
+
+    scratch.resize(count);
+    Entry* from = entries.data();
+    Entry* to = scratch.data();
+    for (int b = 0; b < KEY_BYTES; b++) {
+        uint32_t* counts = histogram[b];
+        if (counts[(from[0].key >> (b * 8)) & 0xFF] == count) continue;
+
+        uint32_t offset = 0;
+        for (int digit = 0; digit < 256; digit++) {
+            uint32_t n = counts[digit];
+            counts[digit] = offset;
+            offset += n;
+        }
+        for (size_t i = 0; i < count; i++) {
+            to[counts[(from[i].key >> (b * 8)) & 0xFF]++] = from[i];
+        }
+        std::swap(from, to);
+    }
+    if (from != entries.data()) entries.swap(scratch);
+}
+
+void RenderQueue::flush() {
+    sort();
+
+    lastRuns = 0;
+    size_t count = entries.size();
+    uint32_t drawingLayer = 0;
+    for (size_t first = 0; first < count;) {
+        uint64_t state = entries[first].key >> STATE_SHIFT;
+        uint32_t runLayer = static_cast<uint32_t>(state >> LAYER_SHIFT);
+        if (observer && (first == 0 || runLayer != drawingLayer)) {
+            if (first > 0) observer->endLayer(drawingLayer);
+            observer->beginLayer(runLayer);
+        }
+        drawingLayer = runLayer;
+        runItems.clear();
+        size_t last = first;
+        for (; last < count && entries[last].key >> STATE_SHIFT == state; last++) {
+            runItems.push_back(entries[last].item);
+        }
+
+        uint32_t shader = static_cast<uint32_t>(state >> 16) & 0xFF;
+        if (shader < shaders.size()) {
+            shaders[shader]->drawRun(shader, runItems.data(), runItems.size());
+            lastRuns++;
+        }
+        first = last;
+    }
+    if (observer && count > 0) observer->endLayer(drawingLayer);
+
+    for (RenderBackend* backend : backends) backend->endFrame();
+    entries.clear();
+    setLayer(LAYER_WORLD, 0);
+}
@@ -0,0 +1,90 @@
+// RenderQueue.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A renderer that draws through a RenderQueue
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    // Items of one run in draw order, all with the same layer, pass,
+    // shader and texture. Items are the ids the backend pushed.
+    virtual void drawRun(uint32_t shader, const uint32_t* items, size_t count) = 0;
+    // Once per flush after the last run, time to drop the frame's items
+    virtual void endFrame() = 0;
+};
+
+// Frame-wide draw queue. Renderers attached to one push a 64 bit sort key
+// and an item id per draw instead of drawing at their own flush. flush()
+// radix sorts the keys and hands each run of equal state back to its
+// renderer, so the frame draws layer by layer with the fewest program and
+// texture switches. Key bits, high to low:
+//
+//     layer 4 | pass 4 | shader 8 | texture 16 | depth 32
+//
+// Within a pass, draws group by program and then texture, so draws of
+// different programs in one pass should not overlap; put what goes on top
+// in a later pass. The sort is stable: equal keys draw in submission order.
+class RenderQueue {
+public:
+    enum Layer : uint32_t {
+        LAYER_WORLD = 0,
+        LAYER_UI = 1,
+        LAYER_WIDGETS = 2,     // buttons and the like, above UI text
+        LAYER_OVERLAY = 3,
+    };
+
+    // Told when flush() starts and finishes drawing each layer that has
+    // draws, e.g. to time the layers apart
+    class Observer {
+    public:
+        virtual ~Observer() = default;
+        virtual void beginLayer(uint32_t layer) = 0;
+        virtual void endLayer(uint32_t layer) = 0;
+    };
+
+    // Ids sort in registration order within a pass. A backend with several
+    // programs registers each one.
+    uint32_t registerShader(RenderBackend* backend);
+
+    // Stamped into the keys pushed from here on. flush() goes back to
+    // LAYER_WORLD, pass 0.
+    void setLayer(uint32_t layer, uint32_t pass = 0);
+    void setPass(uint32_t pass);
+    uint32_t getLayer() const { return layer; }
+    uint32_t getPass() const { return pass; }
+
+    // Only the low 16 bits of texture are part of the key, a backend whose
+    // run can hold two textures that share them splits it itself
+    void push(uint32_t shader, uint32_t texture, uint32_t depth, uint32_t item) {
+        entries.push_back({prefix | (uint64_t)shader << 48 | (uint64_t)(texture & 0xFFFF) << 32 | depth, item});
+    }
+
+    void setObserver(Observer* observer) { this->observer = observer; }
+    void flush();
+
+    size_t size() const { return entries.size(); }
+    int getLastRuns() const { return lastRuns; }   // runs the last flush drew
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t item;
+    };
+
+    void sort();
+
+    uint32_t layer = LAYER_WORLD;
+    uint32_t pass = 0;
+    uint64_t prefix = 0;    // layer and pass bits of the key
+
+    Observer* observer = nullptr;
+    std::vector<RenderBackend*> shaders;    // by shader id
+    std::vector<RenderBackend*> backends;   // each once
+    std::vector<Entry> entries;
+    std::vector<Entry> scratch;             // radix sort ping-pong, reused
+    std::vector<uint32_t> runItems;
+    int lastRuns = 0;
+};
@@ -1,32 +1,48 @@
 // Renderer2D.cpp
-#include "Renderer2D.h"
+#include "renderer2d.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <cstdio>
+#include "logger/logger.h"
+#include "glState/glState.h"
+#include "glState/streamBuffer.h"
 
+// Corners come from gl_VertexID, drawn as a 4 vertex strip per instance
 static const char* rectVertSrc = R"(#version 300 es
 precision mediump float;
-layout(location = 0) in vec2 aPos;
+layout(location = 0) in vec4 aRect;     // x, y, width, height
+layout(location = 1) in vec3 aStyle;    // radius, border width, filled
+layout(location = 2) in vec4 aFill;
+layout(location = 3) in vec4 aBorder;
 out vec2 vLocalPos;
+flat out vec2 vHalfSize;
+flat out vec3 vStyle;
+flat out vec4 vFill;
+flat out vec4 vBorder;
 uniform mat4 uProjection;
-uniform vec2 uPos;
-uniform vec2 uSize;
 
 void main() {
-    vec2 worldPos = uPos + aPos * uSize;
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    vec2 worldPos = aRect.xy + corner * aRect.zw;
     gl_Position = uProjection * vec4(worldPos, 0.0, 1.0);
-    vLocalPos = aPos * uSize;
+    vHalfSize = aRect.zw * 0.5;
+    vLocalPos = corner * aRect.zw - vHalfSize;
+    vStyle = aStyle;
+    vFill = aFill;
+    vBorder = aBorder;
 }
 )";
 
 static const char* rectFragSrc = R"(#version 300 es
 precision mediump float;
 in vec2 vLocalPos;
+flat in vec2 vHalfSize;
+flat in vec3 vStyle;
+flat in vec4 vFill;
+flat in vec4 vBorder;
 out vec4 fragColor;
-uniform vec4 uColor;
-uniform vec2 uSize;
-uniform float uRadius;
-uniform float uBorder;
 
 float roundedBoxSDF(vec2 p, vec2 b, float r) {
     vec2 q = abs(p) - b + r;
@@ -34,48 +50,56 @@ float roundedBoxSDF(vec2 p, vec2 b, float r) {
 }
 
 void main() {
-    vec2 halfSize = uSize * 0.5;
-    vec2 centered = vLocalPos - halfSize;
-    
-    float dist = roundedBoxSDF(centered, halfSize, uRadius);
-    
-    if (uBorder > 0.0) {
-        float innerDist = roundedBoxSDF(centered, halfSize - uBorder, max(0.0, uRadius - uBorder));
-        if (dist > 0.5 || innerDist < -0.5) {
-            discard;
-        }
-        float alpha = smoothstep(0.5, -0.5, dist) * smoothstep(-0.5, 0.5, innerDist);
-        fragColor = vec4(uColor.rgb, uColor.a * alpha);
-    } else {
-        if (dist > 0.5) {
-            discard;
-        }
-        float alpha = smoothstep(0.5, -0.5, dist);
-        fragColor = vec4(uColor.rgb, uColor.a * alpha);
+    float radius = vStyle.x;
+    float border = vStyle.y;
+
+    float dist = roundedBoxSDF(vLocalPos, vHalfSize, radius);
+    if (dist > 0.5) {
+        discard;
+    }
+    float coverage = smoothstep(0.5, -0.5, dist);
+
+    // Border coverage is the outer shape minus the inner one
+    float borderAlpha = 0.0;
+    if (border > 0.0) {
+        float innerDist = roundedBoxSDF(vLocalPos, vHalfSize - border, max(0.0, radius - border));
+        borderAlpha = vBorder.a * coverage * smoothstep(-0.5, 0.5, innerDist);
     }
+    float fillAlpha = vStyle.z * vFill.a * coverage;
+
+    // Border over fill, blended the way two separate draws would be
+    float alpha = borderAlpha + fillAlpha * (1.0 - borderAlpha);
+    if (alpha <= 0.0) {
+        discard;
+    }
+    vec3 color = vBorder.rgb * borderAlpha + vFill.rgb * fillAlpha * (1.0 - borderAlpha);
+    fragColor = vec4(color / alpha, alpha);
 }
 )";
 
-static const char* imageVertSrc = R"(#version 300 es
-layout(location = 0) in vec4 aVertex;
+static const char* spriteVertSrc = R"(#version 300 es
+layout(location = 0) in vec4 aVertex;   // xy = screen position, zw = uv
+layout(location = 1) in vec4 aTint;
 out vec2 vTexCoord;
+out vec4 vTint;
 uniform mat4 uProjection;
 
 void main() {
     gl_Position = uProjection * vec4(aVertex.xy, 0.0, 1.0);
     vTexCoord = aVertex.zw;
+    vTint = aTint;
 }
 )";
 
-static const char* imageFragSrc = R"(#version 300 es
+static const char* spriteFragSrc = R"(#version 300 es
 precision mediump float;
 in vec2 vTexCoord;
+in vec4 vTint;
 out vec4 fragColor;
 uniform sampler2D uTexture;
-uniform vec4 uTint;
 
 void main() {
-    fragColor = texture(uTexture, vTexCoord) * uTint;
+    fragColor = texture(uTexture, vTexCoord) * vTint;
 }
 )";
 
@@ -89,7 +113,7 @@ static GLuint compileShader(GLenum type, const char* src) {
     if (!success) {
         GLchar infoLog[512];
         glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        printf("Shader compile error: %s\n", infoLog);
+        LOG_ERROR(LOG_RENDER, "Shader compile error: %s\n", infoLog);
         return 0;
     }
     return shader;
@@ -100,7 +124,7 @@ static GLuint createProgram(const char* vertSrc, const char* fragSrc) {
     GLuint frag = compileShader(GL_FRAGMENT_SHADER, fragSrc);
     
     if (vert == 0 || frag == 0) {
-        printf("Shader compilation failed!\n");
+        LOG_ERROR(LOG_RENDER, "Shader compilation failed!\n");
         return 0;
     }
     
@@ -114,7 +138,7 @@ static GLuint createProgram(const char* vertSrc, const char* fragSrc) {
     if (!success) {
         GLchar infoLog[512];
         glGetProgramInfoLog(program, 512, nullptr, infoLog);
-        printf("Program link error: %s\n", infoLog);
+        LOG_ERROR(LOG_RENDER, "Program link error: %s\n", infoLog);
         glDeleteShader(vert);
         glDeleteShader(frag);
         return 0;
@@ -127,171 +151,313 @@ static GLuint createProgram(const char* vertSrc, const char* fragSrc) {
 
 void Renderer2D::init() {
     initRectShader();
-    initImageShader();
+    initSpriteShader();
 }
 
 void Renderer2D::initRectShader() {
     rectShader = createProgram(rectVertSrc, rectFragSrc);
     if (rectShader == 0) {
-        printf("Failed to create rect shader program!\n");
+        LOG_ERROR(LOG_RENDER, "Failed to create rect shader program!\n");
         return;
     }
     
-    rectProjLoc = glGetUniformLocation(rectShader, "uProjection");
-    rectColorLoc = glGetUniformLocation(rectShader, "uColor");
-    rectPosLoc = glGetUniformLocation(rectShader, "uPos");
-    rectSizeLoc = glGetUniformLocation(rectShader, "uSize");
-    rectRadiusLoc = glGetUniformLocation(rectShader, "uRadius");
-    rectBorderLoc = glGetUniformLocation(rectShader, "uBorder");
-    
-    printf("Rect shader uniforms: proj=%d color=%d pos=%d size=%d radius=%d border=%d\n",
-           rectProjLoc, rectColorLoc, rectPosLoc, rectSizeLoc, rectRadiusLoc, rectBorderLoc);
+    rectProjLoc = glState.uniformLocation(rectShader, "uProjection");
     
-    float quadVerts[] = {
-        0.0f, 0.0f,
-        1.0f, 0.0f,
-        0.0f, 1.0f,
-        1.0f, 0.0f,
-        1.0f, 1.0f,
-        0.0f, 1.0f
-    };
+    LOG_DEBUG(LOG_RENDER, "Rect shader uniforms: proj=%d\n", rectProjLoc);
     
+    // Every attribute advances per instance, the quad has no vertex data
     glGenVertexArrays(1, &rectVao);
     glGenBuffers(1, &rectVbo);
-    glBindVertexArray(rectVao);
-    glBindBuffer(GL_ARRAY_BUFFER, rectVbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVerts), quadVerts, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+    glState.bindVertexArray(rectVao);
+    glState.bindBuffer(GL_ARRAY_BUFFER, rectVbo);
+    rectCapacity = INITIAL_RECTS;
+    ringRect = 0;
+    glBufferData(GL_ARRAY_BUFFER, rectCapacity * sizeof(RectInstance), nullptr, GL_STREAM_DRAW);
+    for (GLuint attribute = 0; attribute < 4; attribute++) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+    pointRectAttributes(0);
+    glState.bindVertexArray(0);
     
-    printf("Rect shader initialized: program=%u vao=%u vbo=%u\n", rectShader, rectVao, rectVbo);
+    LOG_DEBUG(LOG_RENDER, "Rect shader initialized: program=%u vao=%u vbo=%u\n", rectShader, rectVao, rectVbo);
+}
+
+// Points the instance attributes at firstRect of the bound VBO
+void Renderer2D::pointRectAttributes(size_t firstRect) {
+    size_t base = firstRect * sizeof(RectInstance);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(RectInstance), (void*)(base + offsetof(RectInstance, x)));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(RectInstance), (void*)(base + offsetof(RectInstance, radius)));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(RectInstance), (void*)(base + offsetof(RectInstance, fill)));
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(RectInstance), (void*)(base + offsetof(RectInstance, border)));
 }
 
-void Renderer2D::initImageShader() {
-    imageShader = createProgram(imageVertSrc, imageFragSrc);
-    if (imageShader == 0) {
-        printf("Failed to create image shader program!\n");
+void Renderer2D::initSpriteShader() {
+    spriteShader = createProgram(spriteVertSrc, spriteFragSrc);
+    if (spriteShader == 0) {
+        LOG_ERROR(LOG_RENDER, "Failed to create sprite shader program!\n");
         return;
     }
     
-    imageProjLoc = glGetUniformLocation(imageShader, "uProjection");
-    imageTintLoc = glGetUniformLocation(imageShader, "uTint");
+    spriteProjLoc = glState.uniformLocation(spriteShader, "uProjection");
+    
+    LOG_DEBUG(LOG_RENDER, "Sprite shader uniforms: proj=%d\n", spriteProjLoc);
     
-    printf("Image shader uniforms: proj=%d tint=%d\n", imageProjLoc, imageTintLoc);
+    // Two triangles per sprite; every draw starts at sprite 0 of the
+    // attribute pointers, so one index buffer serves them all
+    std::vector<GLushort> indices;
+    indices.reserve(MAX_SPRITES_PER_DRAW * 6);
+    for (size_t i = 0; i < MAX_SPRITES_PER_DRAW; i++) {
+        GLushort v = static_cast<GLushort>(i * 4);
+        GLushort quad[] = {v, (GLushort)(v + 1), (GLushort)(v + 2), (GLushort)(v + 1), (GLushort)(v + 3), (GLushort)(v + 2)};
+        indices.insert(indices.end(), quad, quad + 6);
+    }
     
-    glGenVertexArrays(1, &imageVao);
-    glGenBuffers(1, &imageVbo);
-    glBindVertexArray(imageVao);
-    glBindBuffer(GL_ARRAY_BUFFER, imageVbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 4 * 6, nullptr, GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glGenVertexArrays(1, &spriteVao);
+    glGenBuffers(1, &spriteVbo);
+    glGenBuffers(1, &spriteIbo);
+    glState.bindVertexArray(spriteVao);
+    glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, spriteIbo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+    glState.bindBuffer(GL_ARRAY_BUFFER, spriteVbo);
+    spriteCapacity = INITIAL_SPRITES;
+    ringSprite = 0;
+    glBufferData(GL_ARRAY_BUFFER, spriteCapacity * 4 * sizeof(SpriteVertex), nullptr, GL_STREAM_DRAW);
     glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+    glEnableVertexAttribArray(1);
+    pointSpriteAttributes(0);
+    glState.bindVertexArray(0);
+    
+    glState.useProgram(spriteShader);
+    glUniform1i(glState.uniformLocation(spriteShader, "uTexture"), 0);
     
-    printf("Image shader initialized: program=%u vao=%u vbo=%u\n", imageShader, imageVao, imageVbo);
+    LOG_DEBUG(LOG_RENDER, "Sprite shader initialized: program=%u vao=%u vbo=%u\n", spriteShader, spriteVao, spriteVbo);
+}
+
+// Points the vertex attributes at firstVertex of the bound VBO; ES3 has no
+// base vertex draws
+void Renderer2D::pointSpriteAttributes(size_t firstVertex) {
+    size_t base = firstVertex * sizeof(SpriteVertex);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)(base + offsetof(SpriteVertex, x)));
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteVertex), (void*)(base + offsetof(SpriteVertex, r)));
 }
 
 void Renderer2D::cleanup() {
-    glDeleteProgram(rectShader);
-    glDeleteVertexArrays(1, &rectVao);
-    glDeleteBuffers(1, &rectVbo);
-    glDeleteProgram(imageShader);
-    glDeleteVertexArrays(1, &imageVao);
-    glDeleteBuffers(1, &imageVbo);
+    glState.deleteProgram(rectShader);
+    glState.deleteVertexArray(rectVao);
+    glState.deleteBuffer(rectVbo);
+    glState.deleteProgram(spriteShader);
+    glState.deleteVertexArray(spriteVao);
+    glState.deleteBuffer(spriteVbo);
+    glState.deleteBuffer(spriteIbo);
+    spriteAtlas.cleanup();
 }
 
 void Renderer2D::setScreenSize(int width, int height) {
     screenWidth = width;
     screenHeight = height;
+    rectProjectionDirty = true;
+    spriteProjectionDirty = true;
+}
+
+void Renderer2D::pushRect(glm::vec2 pos, float width, float height, float radius,
+                          float borderWidth, bool filled, glm::vec4 fillColor, glm::vec4 borderColor) {
+    RectInstance rect = {pos.x, pos.y, width, height, radius, borderWidth, filled ? 1.0f : 0.0f, {}, {}};
+    packUnorm8(fillColor, rect.fill);
+    packUnorm8(borderColor, rect.border);
+    rectQueue.push_back(rect);
+    if (renderQueue) renderQueue->push(rectShaderId, 0, 0, static_cast<uint32_t>(rectQueue.size() - 1));
 }
 
 void Renderer2D::drawFilledRect(glm::vec2 pos, float width, float height, glm::vec4 color) {
-    rectQueue.push_back({pos, width, height, 0.0f, 0.0f, color, true});
+    pushRect(pos, width, height, 0.0f, 0.0f, true, color, glm::vec4(0.0f));
 }
 
 void Renderer2D::drawRect(glm::vec2 pos, float width, float height, float borderWidth, glm::vec4 color) {
-    rectQueue.push_back({pos, width, height, borderWidth, 0.0f, color, false});
+    pushRect(pos, width, height, 0.0f, borderWidth, false, glm::vec4(0.0f), color);
 }
 
 void Renderer2D::drawFilledRoundedRect(glm::vec2 pos, float width, float height, float radius, glm::vec4 color) {
-    rectQueue.push_back({pos, width, height, 0.0f, radius, color, true});
+    pushRect(pos, width, height, radius, 0.0f, true, color, glm::vec4(0.0f));
 }
 
 void Renderer2D::drawRoundedRect(glm::vec2 pos, float width, float height, float borderWidth, float radius, glm::vec4 color) {
-    rectQueue.push_back({pos, width, height, borderWidth, radius, color, false});
+    pushRect(pos, width, height, radius, borderWidth, false, glm::vec4(0.0f), color);
+}
+
+void Renderer2D::drawBorderedRect(glm::vec2 pos, float width, float height, float radius,
+                                  glm::vec4 fillColor, float borderWidth, glm::vec4 borderColor) {
+    pushRect(pos, width, height, radius, borderWidth, true, fillColor, borderColor);
+}
+
+Sprite Renderer2D::addSprite(const unsigned char* rgba, int width, int height) {
+    return spriteAtlas.add(rgba, width, height);
+}
+
+void Renderer2D::drawSprite(const Sprite& sprite, glm::vec2 pos, glm::vec2 size, float rotation,
+                            glm::vec2 origin, glm::vec4 tint) {
+    if (!sprite.valid()) return;
+    
+    // Corners bottom-left, bottom-right, top-left, top-right around the pivot
+    glm::vec2 low = -origin * size;
+    glm::vec2 high = low + size;
+    glm::vec2 corners[4] = {{low.x, low.y}, {high.x, low.y}, {low.x, high.y}, {high.x, high.y}};
+    if (rotation != 0.0f) {
+        float c = std::cos(rotation), s = std::sin(rotation);
+        for (glm::vec2& corner : corners) {
+            corner = glm::vec2(corner.x * c - corner.y * s, corner.x * s + corner.y * c);
+        }
+    }
+    
+    GLubyte r = toUnorm8(tint.r), g = toUnorm8(tint.g), b = toUnorm8(tint.b), a = toUnorm8(tint.a);
+    // Texture rows run top down, so the bottom corners take uv1.y
+    spriteVertices.push_back({pos.x + corners[0].x, pos.y + corners[0].y, sprite.uv0.x, sprite.uv1.y, r, g, b, a});
+    spriteVertices.push_back({pos.x + corners[1].x, pos.y + corners[1].y, sprite.uv1.x, sprite.uv1.y, r, g, b, a});
+    spriteVertices.push_back({pos.x + corners[2].x, pos.y + corners[2].y, sprite.uv0.x, sprite.uv0.y, r, g, b, a});
+    spriteVertices.push_back({pos.x + corners[3].x, pos.y + corners[3].y, sprite.uv1.x, sprite.uv0.y, r, g, b, a});
+    uint32_t order = static_cast<uint32_t>(spriteQueue.size());
+    spriteQueue.push_back({sprite.texture, order});
+    if (renderQueue) renderQueue->push(spriteShaderId, sprite.texture, 0, order);
 }
 
 void Renderer2D::drawImage(GLuint textureId, float x, float y, float width, float height, glm::vec4 tint) {
-    imageQueue.push_back({textureId, x, y, width, height, tint});
+    Sprite sprite;
+    sprite.texture = textureId;
+    drawSprite(sprite, glm::vec2(x, y), glm::vec2(width, height), 0.0f, glm::vec2(0.0f), tint);
+}
+
+void Renderer2D::setRenderQueue(RenderQueue* queue) {
+    renderQueue = queue;
+    if (queue) {
+        rectShaderId = queue->registerShader(this);
+        spriteShaderId = queue->registerShader(this);
+    }
 }
 
 void Renderer2D::flush() {
+    if (renderQueue) return;
     flushRects();
-    flushImages();
+    flushSprites();
 }
 
 void Renderer2D::flushRects() {
     if (rectQueue.empty()) return;
-    if (rectShader == 0) {
-        printf("Rect shader not valid!\n");
-        rectQueue.clear();
-        return;
+    drawRects(rectQueue.data(), rectQueue.size());
+    rectQueue.clear();
+}
+
+// Steady state this does not allocate: the queues keep their capacity
+void Renderer2D::flushSprites() {
+    if (spriteQueue.empty()) return;
+    
+    // Group by texture, submission order within one
+    auto byTexture = [](const QueuedSprite& a, const QueuedSprite& b) {
+        return a.texture != b.texture ? a.texture < b.texture : a.order < b.order;
+    };
+    if (!std::is_sorted(spriteQueue.begin(), spriteQueue.end(), byTexture)) {
+        std::sort(spriteQueue.begin(), spriteQueue.end(), byTexture);
     }
+    drawSprites(spriteQueue.data(), spriteQueue.size());
     
+    spriteQueue.clear();
+    spriteVertices.clear();
+}
+
+void Renderer2D::drawRun(uint32_t shader, const uint32_t* items, size_t count) {
+    if (shader == rectShaderId) {
+        // Rects submitted back to back are already contiguous in the queue
+        if (items[count - 1] - items[0] == count - 1) {
+            drawRects(rectQueue.data() + items[0], count);
+            return;
+        }
+        runRects.clear();
+        for (size_t i = 0; i < count; i++) runRects.push_back(rectQueue[items[i]]);
+        drawRects(runRects.data(), count);
+    } else {
+        runSprites.clear();
+        for (size_t i = 0; i < count; i++) runSprites.push_back(spriteQueue[items[i]]);
+        drawSprites(runSprites.data(), count);
+    }
+}
+
+void Renderer2D::endFrame() {
+    rectQueue.clear();
+    spriteQueue.clear();
+    spriteVertices.clear();
+}
+
+// Sets the projection of the bound program when the screen size changed
+// since it was last set
+void Renderer2D::applyProjection(GLint location, bool& dirty) {
+    if (!dirty) return;
     glm::mat4 proj = glm::ortho(0.0f, (float)screenWidth, 0.0f, (float)screenHeight, -1.0f, 1.0f);
-    
-    glUseProgram(rectShader);
-    glUniformMatrix4fv(rectProjLoc, 1, GL_FALSE, glm::value_ptr(proj));
-    glBindVertexArray(rectVao);
-    
-    for (auto& r : rectQueue) {
-        glUniform4f(rectColorLoc, r.color.r, r.color.g, r.color.b, r.color.a);
-        glUniform2f(rectPosLoc, r.pos.x, r.pos.y);
-        glUniform2f(rectSizeLoc, r.width, r.height);
-        glUniform1f(rectRadiusLoc, r.radius);
-        glUniform1f(rectBorderLoc, r.filled ? 0.0f : r.borderWidth);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(proj));
+    dirty = false;
+}
+
+void Renderer2D::drawRects(const RectInstance* rects, size_t count) {
+    if (rectShader == 0) {
+        LOG_ERROR_EVERY(LOG_RENDER, 1000.0, "Rect shader not valid!\n");
+        return;
     }
     
-    glBindVertexArray(0);
-    rectQueue.clear();
+    glState.setBlend(true);
+    glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glState.useProgram(rectShader);
+    applyProjection(rectProjLoc, rectProjectionDirty);
+    glState.bindVertexArray(rectVao);
+    glState.bindBuffer(GL_ARRAY_BUFFER, rectVbo);
+    
+    // All rects are one draw
+    reserveStream(ringRect, rectCapacity, count, sizeof(RectInstance));
+    glBufferSubData(GL_ARRAY_BUFFER, ringRect * sizeof(RectInstance), count * sizeof(RectInstance), rects);
+    pointRectAttributes(ringRect);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(count));
+    ringRect += count;
 }
 
-void Renderer2D::flushImages() {
-    if (imageQueue.empty()) return;
-    if (imageShader == 0) {
-        printf("Image shader not valid!\n");
-        imageQueue.clear();
+// Sprites come grouped by texture
+void Renderer2D::drawSprites(const QueuedSprite* sprites, size_t count) {
+    if (spriteShader == 0) {
+        LOG_ERROR_EVERY(LOG_RENDER, 1000.0, "Sprite shader not valid!\n");
         return;
     }
     
-    glm::mat4 proj = glm::ortho(0.0f, (float)screenWidth, 0.0f, (float)screenHeight, -1.0f, 1.0f);
+    glState.setBlend(true);
+    glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glState.useProgram(spriteShader);
+    applyProjection(spriteProjLoc, spriteProjectionDirty);
+    glState.bindVertexArray(spriteVao);
+    glState.bindBuffer(GL_ARRAY_BUFFER, spriteVbo);
+    
+    // Sprites still in submission order upload as they are
+    const SpriteVertex* vertices = spriteVertices.data() + sprites[0].order * 4;
+    for (size_t i = 1; i < count; i++) {
+        if (sprites[i].order != sprites[0].order + i) {
+            sortedVertices.clear();
+            for (size_t j = 0; j < count; j++) {
+                const SpriteVertex* corners = spriteVertices.data() + sprites[j].order * 4;
+                sortedVertices.insert(sortedVertices.end(), corners, corners + 4);
+            }
+            vertices = sortedVertices.data();
+            break;
+        }
+    }
     
-    glUseProgram(imageShader);
-    glUniformMatrix4fv(imageProjLoc, 1, GL_FALSE, glm::value_ptr(proj));
-    glBindVertexArray(imageVao);
-    glBindBuffer(GL_ARRAY_BUFFER, imageVbo);
+    // All of it in one upload
+    reserveStream(ringSprite, spriteCapacity, count, 4 * sizeof(SpriteVertex));
+    glBufferSubData(GL_ARRAY_BUFFER, ringSprite * 4 * sizeof(SpriteVertex), count * 4 * sizeof(SpriteVertex), vertices);
     
-    for (auto& img : imageQueue) {
-        float x = img.x, y = img.y, w = img.width, h = img.height;
-        
-        float verts[] = {
-            x,     y,     0.0f, 1.0f,
-            x + w, y,     1.0f, 1.0f,
-            x,     y + h, 0.0f, 0.0f,
-            x + w, y,     1.0f, 1.0f,
-            x + w, y + h, 1.0f, 0.0f,
-            x,     y + h, 0.0f, 0.0f
-        };
+    // One draw per texture, split only past what 16-bit indices address
+    for (size_t first = 0; first < count;) {
+        GLuint texture = sprites[first].texture;
+        size_t last = first + 1;
+        while (last < count && last - first < MAX_SPRITES_PER_DRAW && sprites[last].texture == texture) last++;
         
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
-        glUniform4f(imageTintLoc, img.tint.r, img.tint.g, img.tint.b, img.tint.a);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, img.textureId);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        glState.bindTexture(0, texture);
+        pointSpriteAttributes((ringSprite + first) * 4);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>((last - first) * 6), GL_UNSIGNED_SHORT, (void*)0);
+        first = last;
     }
-    
-    glBindVertexArray(0);
-    imageQueue.clear();
-}
\ No newline at end of file
+    ringSprite += count;
+}
@@ -1,10 +1,13 @@
 // Renderer2D.h
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <glm/glm.hpp>
 #include <GLES3/gl3.h>
+#include "spriteAtlas.h"
+#include "renderQueue/renderQueue.h"
 
-class Renderer2D {
+class Renderer2D : public RenderBackend {
 public:
     void init();
     void cleanup();
@@ -14,31 +17,74 @@ public:
     void drawRect(glm::vec2 pos, float width, float height, float borderWidth, glm::vec4 color);
     void drawFilledRoundedRect(glm::vec2 pos, float width, float height, float radius, glm::vec4 color);
     void drawRoundedRect(glm::vec2 pos, float width, float height, float borderWidth, float radius, glm::vec4 color);
+    // Fill with a border on top in one rect, what a filled rect followed by
+    // a border rect draws
+    void drawBorderedRect(glm::vec2 pos, float width, float height, float radius,
+                          glm::vec4 fillColor, float borderWidth, glm::vec4 borderColor);
     
+    // Packs RGBA8 pixels (top row first) into the sprite atlas; sprites on
+    // one atlas page draw in a single batch
+    Sprite addSprite(const unsigned char* rgba, int width, int height);
+
+    // Sprites are drawn sorted by texture, one draw per texture page, so
+    // sprites on different textures keep no order among themselves within
+    // a flush. origin is the pivot as a fraction of size from the bottom-left
+    // corner; pos is where it lands and rotation (radians, counterclockwise)
+    // turns the sprite about it.
+    void drawSprite(const Sprite& sprite, glm::vec2 pos, glm::vec2 size, float rotation = 0.0f,
+                    glm::vec2 origin = glm::vec2(0.0f), glm::vec4 tint = glm::vec4(1.0f));
+    // Whole texture at (x, y), bottom-left corner
     void drawImage(GLuint textureId, float x, float y, float width, float height, glm::vec4 tint = glm::vec4(1.0f));
     
+    // Draws go to the queue from then on, in its current layer and pass,
+    // and flush() does nothing; the queue draws them
+    void setRenderQueue(RenderQueue* queue);
     void flush();
 
+    void drawRun(uint32_t shader, const uint32_t* items, size_t count) override;
+    void endFrame() override;
+
 private:
-    struct RectData {
-        glm::vec2 pos;
-        float width, height;
-        float borderWidth;
-        float radius;
-        glm::vec4 color;
-        bool filled;
+    // Rects the streaming VBO holds before it has to grow
+    static constexpr size_t INITIAL_RECTS = 4096;
+
+    // One instance per rect; the vertex shader expands it to a quad and the
+    // fragment shader evaluates fill and border from one SDF. RGBA8 is
+    // normalized to 0..1.
+    struct RectInstance {
+        GLfloat x, y, width, height;
+        GLfloat radius, borderWidth, filled;
+        GLubyte fill[4];
+        GLubyte border[4];
     };
     
-    struct ImageData {
-        GLuint textureId;
-        float x, y, width, height;
-        glm::vec4 tint;
+    // Sprites per draw, as far as 16-bit indices reach
+    static constexpr size_t MAX_SPRITES_PER_DRAW = 16384;
+    static constexpr size_t INITIAL_SPRITES = 4096;
+
+    // Four per sprite, corners already rotated into screen space
+    struct SpriteVertex {
+        GLfloat x, y, u, v;
+        GLubyte r, g, b, a;
+    };
+
+    // Vertices of queued sprite order are spriteVertices[4 * order]
+    struct QueuedSprite {
+        GLuint texture;
+        uint32_t order;
     };
     
     void initRectShader();
-    void initImageShader();
+    void initSpriteShader();
+    void pushRect(glm::vec2 pos, float width, float height, float radius,
+                  float borderWidth, bool filled, glm::vec4 fillColor, glm::vec4 borderColor);
+    void pointRectAttributes(size_t firstRect);
+    void applyProjection(GLint location, bool& dirty);
+    void drawRects(const RectInstance* rects, size_t count);
+    void drawSprites(const QueuedSprite* sprites, size_t count);
     void flushRects();
-    void flushImages();
+    void pointSpriteAttributes(size_t firstVertex);
+    void flushSprites();
     
     int screenWidth = 800;
     int screenHeight = 600;
@@ -47,17 +93,27 @@ private:
     GLuint rectVao = 0;
     GLuint rectVbo = 0;
     GLint rectProjLoc = -1;
-    GLint rectColorLoc = -1;
-    GLint rectPosLoc = -1;
-    GLint rectSizeLoc = -1;
-    GLint rectRadiusLoc = -1;
-    GLint rectBorderLoc = -1;
-    std::vector<RectData> rectQueue;
-    
-    GLuint imageShader = 0;
-    GLuint imageVao = 0;
-    GLuint imageVbo = 0;
-    GLint imageProjLoc = -1;
-    GLint imageTintLoc = -1;
-    std::vector<ImageData> imageQueue;
+    size_t rectCapacity = 0;    // rects the VBO holds
+    size_t ringRect = 0;        // next free rect in the VBO
+    bool rectProjectionDirty = true;
+    std::vector<RectInstance> rectQueue;
+    std::vector<RectInstance> runRects;     // a queue run gathered, reused
+    
+    GLuint spriteShader = 0;
+    GLuint spriteVao = 0;
+    GLuint spriteVbo = 0;
+    GLuint spriteIbo = 0;
+    GLint spriteProjLoc = -1;
+    size_t spriteCapacity = 0;  // sprites the VBO holds
+    size_t ringSprite = 0;      // next free sprite in the VBO
+    SpriteAtlas spriteAtlas;
+    std::vector<QueuedSprite> spriteQueue;
+    std::vector<SpriteVertex> spriteVertices;   // in submission order
+    std::vector<SpriteVertex> sortedVertices;   // reused between flushes
+    std::vector<QueuedSprite> runSprites;       // a queue run gathered, reused
+    bool spriteProjectionDirty = true;
+    
+    RenderQueue* renderQueue = nullptr;
+    uint32_t rectShaderId = 0;
+    uint32_t spriteShaderId = 0;
 };
\ No newline at end of file
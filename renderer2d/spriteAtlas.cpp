@@ -0,0 +1,94 @@
+// SpriteAtlas.cpp
+#include "spriteAtlas.h"
+#include <algorithm>
+#include <cstring>
+#include "logger/logger.h"
+#include "glState/glState.h"
+
+Sprite Sprite::region(int x, int y, int w, int h) const {
+    if (width <= 0 || height <= 0) {
+        LOG_ERROR_EVERY(LOG_RENDER, 1000, "Sprite region %d,%d %dx%d of a sprite without a pixel size\n", x, y, w, h);
+        return Sprite();
+    }
+    Sprite sub = *this;
+    glm::vec2 size(width, height);
+    glm::vec2 extent = uv1 - uv0;
+    sub.uv0 = uv0 + extent * (glm::vec2(x, y) / size);
+    sub.uv1 = uv0 + extent * (glm::vec2(x + w, y + h) / size);
+    sub.width = w;
+    sub.height = h;
+    return sub;
+}
+
+GLuint SpriteAtlas::createTexture(int width, int height, const unsigned char* rgba) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glState.bindTexture(0, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+Sprite SpriteAtlas::add(const unsigned char* rgba, int width, int height) {
+    Sprite sprite;
+    if (!rgba || width <= 0 || height <= 0) return sprite;
+    sprite.width = width;
+    sprite.height = height;
+
+    int paddedWidth = width + 2 * PADDING;
+    int paddedHeight = height + 2 * PADDING;
+    if (paddedWidth > PAGE_SIZE || paddedHeight > PAGE_SIZE) {
+        sprite.texture = createTexture(width, height, rgba);
+        ownTextures.push_back(sprite.texture);
+        LOG_INFO(LOG_RENDER, "SpriteAtlas: %dx%d sprite gets its own texture\n", width, height);
+        return sprite;
+    }
+
+    // First page with room, else a new one
+    int x = 0, y = 0;
+    Page* page = nullptr;
+    for (Page& candidate : pages) {
+        if (candidate.packer.pack(paddedWidth, paddedHeight, x, y) >= 0) {
+            page = &candidate;
+            break;
+        }
+    }
+    if (!page) {
+        pages.push_back({createTexture(PAGE_SIZE, PAGE_SIZE, nullptr), ShelfPacker()});
+        page = &pages.back();
+        page->packer.reset(PAGE_SIZE, PAGE_SIZE);
+        page->packer.pack(paddedWidth, paddedHeight, x, y);
+        LOG_INFO(LOG_RENDER, "SpriteAtlas: page %d\n", (int)pages.size());
+    }
+
+    // Copy with the edge rows and columns repeated into the padding
+    padded.resize((size_t)paddedWidth * paddedHeight * 4);
+    for (int row = 0; row < paddedHeight; row++) {
+        int sourceRow = std::clamp(row - PADDING, 0, height - 1);
+        const unsigned char* source = rgba + (size_t)sourceRow * width * 4;
+        unsigned char* dest = padded.data() + (size_t)row * paddedWidth * 4;
+        for (int i = 0; i < PADDING; i++) {
+            memcpy(dest + i * 4, source, 4);
+            memcpy(dest + (PADDING + width + i) * 4, source + (width - 1) * 4, 4);
+        }
+        memcpy(dest + PADDING * 4, source, (size_t)width * 4);
+    }
+
+    glState.bindTexture(0, page->texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, paddedWidth, paddedHeight, GL_RGBA, GL_UNSIGNED_BYTE, padded.data());
+
+    sprite.texture = page->texture;
+    sprite.uv0 = glm::vec2(x + PADDING, y + PADDING) / (float)PAGE_SIZE;
+    sprite.uv1 = glm::vec2(x + PADDING + width, y + PADDING + height) / (float)PAGE_SIZE;
+    return sprite;
+}
+
+void SpriteAtlas::cleanup() {
+    for (Page& page : pages) glState.deleteTexture(page.texture);
+    for (GLuint texture : ownTextures) glState.deleteTexture(texture);
+    pages.clear();
+    ownTextures.clear();
+}
@@ -0,0 +1,50 @@
+// SpriteAtlas.h
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include <GLES3/gl3.h>
+#include "shelfPacker/shelfPacker.h"
+
+// Part of a texture to draw. uv0 is the top-left corner in texture
+// coordinates, uv1 the bottom-right, so a whole stb_image texture is
+// (0, 0) to (1, 1).
+struct Sprite {
+    GLuint texture = 0;
+    glm::vec2 uv0 = glm::vec2(0.0f);
+    glm::vec2 uv1 = glm::vec2(1.0f);
+    int width = 0, height = 0;      // pixels, 0 when not known
+
+    // Sub-rect in this sprite's pixels, from its top-left corner. Needs the
+    // pixel size: a sprite without one (drawImage's) gives an invalid sprite.
+    Sprite region(int x, int y, int w, int h) const;
+    bool valid() const { return texture != 0; }
+};
+
+// RGBA8 texture pages sprites are shelf packed into at load time, so
+// sprites on one page draw together. Each sprite is surrounded by a copy of
+// its edge pixels so linear filtering does not pick up its neighbours.
+// Sprites larger than a page get a texture of their own.
+class SpriteAtlas {
+public:
+    static const int PAGE_SIZE = 1024;
+    static const int PADDING = 1;
+
+    // Pixels are tightly packed RGBA8, top row first like stb_image gives
+    // them. Invalid sprite when no texture could be made.
+    Sprite add(const unsigned char* rgba, int width, int height);
+    void cleanup();
+
+    int getPageCount() const { return (int)pages.size(); }
+
+private:
+    struct Page {
+        GLuint texture;
+        ShelfPacker packer;
+    };
+
+    GLuint createTexture(int width, int height, const unsigned char* rgba);
+
+    std::vector<Page> pages;
+    std::vector<GLuint> ownTextures;    // sprites too big for a page
+    std::vector<unsigned char> padded;  // staging for one padded sprite
+};
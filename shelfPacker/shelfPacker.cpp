@@ -0,0 +1,43 @@
+// ShelfPacker.cpp
+#include "shelfPacker.h"
+
+void ShelfPacker::reset(int width, int height) {
+    this->width = width;
+    this->height = height;
+    bottom = 0;
+    shelves.clear();
+}
+
+int ShelfPacker::pack(int w, int h, int& x, int& y) {
+    if (w > width) return -1;
+
+    // Tightest shelf with room, but only reuse one much taller than the rect
+    // when no new shelf can open
+    int best = -1, loose = -1;
+    for (int i = 0; i < (int)shelves.size(); i++) {
+        const Shelf& shelf = shelves[i];
+        if (shelf.height < h || shelf.used + w > width) continue;
+
+        if (shelf.height <= h + h / 4 + 2) {
+            if (best < 0 || shelf.height < shelves[best].height) best = i;
+        } else if (loose < 0 || shelf.height < shelves[loose].height) {
+            loose = i;
+        }
+    }
+
+    // Round shelf heights up so similar glyphs share them after eviction
+    int shelfHeight = (h + 3) & ~3;
+    if (best < 0 && bottom + shelfHeight <= height) {
+        shelves.push_back({bottom, shelfHeight, 0});
+        bottom += shelfHeight;
+        best = (int)shelves.size() - 1;
+    }
+    if (best < 0) best = loose;
+    if (best < 0) return -1;
+
+    Shelf& shelf = shelves[best];
+    x = shelf.used;
+    y = shelf.y;
+    shelf.used += w;
+    return best;
+}
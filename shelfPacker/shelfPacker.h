@@ -0,0 +1,29 @@
+// ShelfPacker.h
+#pragma once
+#include <vector>
+
+// Shelf packer: rects go left to right on a shelf (row) of similar height,
+// new shelves open below the last one. Shelves can be emptied and refilled,
+// which is how GlyphCache evicts.
+class ShelfPacker {
+public:
+    struct Shelf {
+        int y, height;
+        int used;       // next free column
+    };
+
+    void reset(int width, int height);
+    void setHeight(int height) { this->height = height; }
+
+    // Shelf index the rect went to, -1 when nothing fits
+    int pack(int w, int h, int& x, int& y);
+    void clearShelf(int shelf) { shelves[shelf].used = 0; }
+
+    int getBottom() const { return bottom; }
+    const std::vector<Shelf>& getShelves() const { return shelves; }
+
+private:
+    int width = 0, height = 0;
+    int bottom = 0;     // first row below the last shelf
+    std::vector<Shelf> shelves;
+};
@@ -1,15 +1,18 @@
 #include "starship.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stbImage/stb_image.h"
-#include <emscripten/emscripten.h>
+#include "logger/logger.h"
+#include "platform/platform.h"
+#include "glState/glState.h"
+#include "frameData/frameData.h"
+#include <algorithm>
+#include <cstddef>
 
 // Shader with rotation matrix
-static const char* gridVertexShader = R"(#version 300 es
+static const char* gridVertexShader = "#version 300 es\n" FRAME_DATA_GLSL R"(
 layout(location = 0) in vec2 aPos;
-uniform mat4 uProjection;
-uniform mat3 uRotation;
 void main() {
-    vec3 rotated = uRotation * vec3(aPos, 1.0);
+    vec3 rotated = uShipRotation * vec3(aPos, 1.0);
     gl_Position = uProjection * vec4(rotated.xy, 0.0, 1.0);
 }
 )";
@@ -22,37 +25,52 @@ void main() {
 }
 )";
 
-static const char* cellVertexShader = R"(#version 300 es
+static const char* cellVertexShader = "#version 300 es\n" FRAME_DATA_GLSL R"(
 layout(location = 0) in vec2 aPos;
 
-uniform mat4 uTransforms[256];
-uniform vec2 uTexCoords[768];
-uniform vec4 uColors[256];
-
-uniform mat4 uProjection;
-uniform mat3 uShipRotation;
+// Per-instance attributes
+layout(location = 1) in vec4 aInstance;   // xy = position, z = rotation, w = visible
+layout(location = 2) in vec4 aAtlasRect;  // u0, v0, u1, v2
+layout(location = 3) in vec4 aColor;
 
 out vec2 vTexCoord;
 out vec2 vLocalUV;
 out vec4 vColor;
 
 void main() {
-    mat4 model = uTransforms[gl_InstanceID];
-    vTexCoord = uTexCoords[gl_InstanceID * 3 + gl_VertexID];
-    vColor = uColors[gl_InstanceID];
-    
+    vColor = aColor;
+
+    // Dead cells keep their slot but are pushed outside the clip volume
+    if(aInstance.w == 0.0) {
+        vTexCoord = vec2(0.0);
+        vLocalUV = vec2(0.0);
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+
+    // Triangle UVs are rebuilt from the atlas rect: (u0,v0), (u1,v0), (u1,v2)
     // Hardcoded local UVs for border calculation
-    if(gl_VertexID == 0) vLocalUV = vec2(0.0, 0.0);
-    else if(gl_VertexID == 1) vLocalUV = vec2(1.0, 0.0);
-    else vLocalUV = vec2(1.0, 1.0);
-    
-    vec4 localPos = model * vec4(aPos, 0.0, 1.0);
-    vec3 rotated = uShipRotation * vec3(localPos.xy, 1.0);
+    if(gl_VertexID == 0) {
+        vTexCoord = aAtlasRect.xy;
+        vLocalUV = vec2(0.0, 0.0);
+    } else if(gl_VertexID == 1) {
+        vTexCoord = aAtlasRect.zy;
+        vLocalUV = vec2(1.0, 0.0);
+    } else {
+        vTexCoord = aAtlasRect.zw;
+        vLocalUV = vec2(1.0, 1.0);
+    }
+
+    float c = cos(aInstance.z);
+    float s = sin(aInstance.z);
+    vec2 localPos = vec2(aPos.x * c - aPos.y * s, aPos.x * s + aPos.y * c) + aInstance.xy;
+
+    vec3 rotated = uShipRotation * vec3(localPos, 1.0);
     gl_Position = uProjection * vec4(rotated.xy, 0.0, 1.0);
 }
 )";
 
-static const char* cellFragmentShader = R"(#version 300 es
+static const char* cellFragmentShader = "#version 300 es\n" FRAME_DATA_GLSL R"(
 precision mediump float;
 
 in vec2 vTexCoord;
@@ -63,7 +81,6 @@ out vec4 fragColor;
 uniform sampler2D uAtlas;
 uniform sampler2D uCrackTex;
 uniform float uBorderWidth;
-uniform float uTime;
 
 void main() {
     float distFromBottom = vLocalUV.y;
@@ -87,30 +104,40 @@ void main() {
 }
 )";
 
-const char* cannonVertexShader = R"(#version 300 es
+const char* cannonVertexShader = "#version 300 es\n" FRAME_DATA_GLSL R"(
 precision highp float;
 
 layout(location = 0) in vec2 aPos;
 layout(location = 1) in vec2 aTexCoord;
 
-const int MAX_CANNONS = 256;
+// Per-instance attributes
+layout(location = 2) in vec4 aCannon;       // xy = position, zw = own target
+layout(location = 3) in vec4 aCannonState;  // x = aim at target, y = last fired, z = cooldown
 
-uniform vec2 uCannonPositions[MAX_CANNONS];
-uniform float uCannonAngle;
-uniform mat4 uProjection;
-uniform mat3 uShipRotation;
+uniform vec2 uCursor;      // world space, before ship rotation
+uniform float uRecoil;     // how far the barrel kicks back when fired
 
 out vec2 vTexCoord;
 
 void main() {
-    vec2 pos = uCannonPositions[gl_InstanceID];
-    
-    float c = cos(uCannonAngle);
-    float s = sin(uCannonAngle);
+    vec2 pos = aCannon.xy;
+
+    // Bring the cursor into ship space; each cannon aims from its own position
+    vec2 cursor = (transpose(uShipRotation) * vec3(uCursor, 0.0)).xy;
+    vec2 aim = aCannonState.x > 0.5 ? aCannon.zw : cursor;
+    vec2 dir = aim - pos;
+    float angle = atan(dir.y, dir.x);
+
+    float c = cos(angle);
+    float s = sin(angle);
+
+    // Barrel recoils after firing and slides back over the cooldown
+    float sinceFired = (uTime - aCannonState.y) / max(aCannonState.z, 0.001);
+    vec2 local = aPos - vec2(uRecoil * (1.0 - clamp(sinceFired, 0.0, 1.0)), 0.0);
     
     vec2 rotated = vec2(
-        aPos.x * c - aPos.y * s,
-        aPos.x * s + aPos.y * c
+        local.x * c - local.y * s,
+        local.x * s + local.y * c
     );
     
     vec2 vertex = rotated + pos;
@@ -137,7 +164,6 @@ void main() {
 }
 )";
 
-extern glm::mat4 projection;  // access the global
 
 //texture(uCrackTex, vLocalUV).r;
 static GLuint compileShader(GLenum type, const char* src) {
@@ -151,7 +177,6 @@ Starship::Starship()
     : gridVAO(0),
       gridVBO(0),
       gridShader(0),
-      rotationUniformLoc(-1),
       gridVertexCount(0),
       currentRotation(0.0f),
       dragStartRotation(0.0f),
@@ -170,13 +195,13 @@ static GLuint loadTexture(const char* path) {
     unsigned char* data = stbi_load(path, &width, &height, &channels, 4);  // force RGBA
     
     if(!data) {
-        printf("Failed to load texture: %s\n", path);
+        LOG_ERROR(LOG_ASSET, "Failed to load texture: %s\n", path);
         return 0;
     }
     
     GLuint texture;
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    glState.bindTexture(0, texture);
     
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
     
@@ -187,7 +212,7 @@ static GLuint loadTexture(const char* path) {
     
     stbi_image_free(data);
     
-    printf("Loaded texture: %s (%dx%d)\n", path, width, height);
+    LOG_INFO(LOG_ASSET, "Loaded texture: %s (%dx%d)\n", path, width, height);
     return texture;
 }
 
@@ -196,13 +221,13 @@ GLuint loadTextureBlurry(const char* path) {
     unsigned char* data = stbi_load(path, &width, &height, &channels, 4);  // force RGBA
     
     if(!data) {
-        printf("Failed to load texture: %s\n", path);
+        LOG_ERROR(LOG_ASSET, "Failed to load texture: %s\n", path);
         return 0;
     }
     
     GLuint texture;
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    glState.bindTexture(0, texture);
     
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
     
@@ -215,69 +240,78 @@ GLuint loadTextureBlurry(const char* path) {
     
     stbi_image_free(data);
     
-    printf("Loaded texture: %s (%dx%d)\n", path, width, height);
+    LOG_INFO(LOG_ASSET, "Loaded texture: %s (%dx%d)\n", path, width, height);
     return texture;
 }
 
 
 void Starship::updateCannonPositions() {
-    glm::vec2 cannonPositions[MAX_CANNONS];
-    cannonCount = 0;
+    cannonInstances.clear();
+    cells.forEachAlive([&](int i) {
+        const CannonState& state = cannonStates[i];
+        CannonInstance instance;
+        instance.position = cells.center[i];
+        instance.target = state.target;
+        instance.aimAtTarget = state.aimAtTarget ? 1.0f : 0.0f;
+        instance.lastFired = state.lastFired;
+        instance.cooldown = state.cooldown;
+        instance.pad = 0.0f;
+        cannonInstances.push_back(instance);
+    });
+    cannonCount = (int)cannonInstances.size();
+    cannonsDirty = false;
+
+    if (cannonInstanceVBO == 0) return;
+
+    glState.bindBuffer(GL_ARRAY_BUFFER, cannonInstanceVBO);
+
+    // One slot per grid triangle, so a full ship always fits
+    if (cells.size() > (int)cannonInstanceCapacity) {
+        cannonInstanceCapacity = cells.size();
+        glBufferData(GL_ARRAY_BUFFER, cannonInstanceCapacity * sizeof(CannonInstance), nullptr, GL_DYNAMIC_DRAW);
+    }
 
-    for (int i = 0; i < cells.size() && cannonCount < MAX_CANNONS; ++i) {
-        if (cells[i].cellAlive) {
-            cannonPositions[cannonCount] = cells[i].middleOfTriangle;
-            cannonCount++;
-        }
+    if (cannonCount > 0) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, cannonCount * sizeof(CannonInstance), cannonInstances.data());
     }
+}
 
-    glUseProgram(cannonShader);
-    glUniform2fv(uCannonPositionsLoc, cannonCount, glm::value_ptr(cannonPositions[0]));
+void Starship::setCannonTarget(int cellNumber, glm::vec2 target) {
+    if (cellNumber < 1 || cellNumber > cells.size()) return;
+    CannonState& state = cannonStates[cellNumber - 1];
+    state.target = target;
+    state.aimAtTarget = true;
+    cannonsDirty = true;
 }
 
-void Starship::initCannons() {
-    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
-    GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(vs, 1, &cannonVertexShader, nullptr);
-    glShaderSource(fs, 1, &cannonFragmentShader, nullptr);
-    glCompileShader(vs);
-    glCompileShader(fs);
-    cannonShader = glCreateProgram();
-    glAttachShader(cannonShader, vs);
-    glAttachShader(cannonShader, fs);
-    glLinkProgram(cannonShader);
-    glDeleteShader(vs);
-    glDeleteShader(fs);
+void Starship::clearCannonTarget(int cellNumber) {
+    if (cellNumber < 1 || cellNumber > cells.size()) return;
+    cannonStates[cellNumber - 1].aimAtTarget = false;
+    cannonsDirty = true;
+}
 
-    // Cache uniform locations
-    uCannonPositionsLoc = glGetUniformLocation(cannonShader, "uCannonPositions");
-    uCannonAngleLoc = glGetUniformLocation(cannonShader, "uCannonAngle");
-    uShipRotationLoc = glGetUniformLocation(cannonShader, "uShipRotation");
-    uProjectionLoc = glGetUniformLocation(cannonShader, "uProjection");
-    uTextureLoc = glGetUniformLocation(cannonShader, "uTexture");
-
-    printf("uCannonPositionsLoc=%d\n", uCannonPositionsLoc);
-    printf("uCannonAngleLoc=%d\n", uCannonAngleLoc);
-    printf("uShipRotationLoc=%d\n", uShipRotationLoc);
-    printf("uProjectionLoc=%d\n", uProjectionLoc);
-    printf("uTextureLoc=%d\n", uTextureLoc);
-
-    // Set projection once
-    glUseProgram(cannonShader);
-    glUniformMatrix4fv(uProjectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+void Starship::fireCannon(int cellNumber, float cooldown) {
+    if (cellNumber < 1 || cellNumber > cells.size()) return;
+    CannonState& state = cannonStates[cellNumber - 1];
+    state.lastFired = platform::nowMs() / 1000.0f;
+    state.cooldown = cooldown;
+    cannonsDirty = true;
+}
 
+void Starship::buildCannonQuad() {
     struct CannonVertex {
         float x, y;
         float u, v;
     };
 
-    float pivotOffset = 0.020f;
+    // Sized relative to the cell, tuned at the default 0.12 cell size
+    float pivotOffset = cellSize * 0.1667f;
 
     float texWidth = 1600.0f;
     float texHeight = 500.0f;
     float aspect = texWidth / texHeight;
 
-    float height = 0.027f;
+    float height = cellSize * 0.225f;
     float width = height * aspect;
 
     CannonVertex cannonQuad[] = {
@@ -289,16 +323,63 @@ void Starship::initCannons() {
         {-pivotOffset,         height,  0.0f, 1.0f},
     };
 
+    glState.bindBuffer(GL_ARRAY_BUFFER, cannonVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(cannonQuad), cannonQuad, GL_STATIC_DRAW);
+
+    glState.useProgram(cannonShader);
+    glUniform1f(uRecoilLoc, pivotOffset);
+}
+
+void Starship::initCannons() {
+    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
+    GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(vs, 1, &cannonVertexShader, nullptr);
+    glShaderSource(fs, 1, &cannonFragmentShader, nullptr);
+    glCompileShader(vs);
+    glCompileShader(fs);
+    cannonShader = glCreateProgram();
+    glAttachShader(cannonShader, vs);
+    glAttachShader(cannonShader, fs);
+    glLinkProgram(cannonShader);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    FrameData::bindProgram(cannonShader);
+
+    // Cache uniform locations
+    uCursorLoc = glState.uniformLocation(cannonShader, "uCursor");
+    uRecoilLoc = glState.uniformLocation(cannonShader, "uRecoil");
+    uTextureLoc = glState.uniformLocation(cannonShader, "uTexture");
+
+    LOG_DEBUG(LOG_RENDER, "Cannon uniforms: cursor=%d recoil=%d texture=%d\n",
+              uCursorLoc, uRecoilLoc, uTextureLoc);
+
+    // Texture unit never changes
+    glState.useProgram(cannonShader);
+    glUniform1i(uTextureLoc, 1);
+
     glGenVertexArrays(1, &cannonVAO);
     glGenBuffers(1, &cannonVBO);
-    glBindVertexArray(cannonVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, cannonVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cannonQuad), cannonQuad, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(CannonVertex), (void*)0);
+    glGenBuffers(1, &cannonInstanceVBO);
+    glState.bindVertexArray(cannonVAO);
+
+    buildCannonQuad();
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(CannonVertex), (void*)(2 * sizeof(float)));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
     glEnableVertexAttribArray(1);
-    glBindVertexArray(0);
+
+    // Per-cannon state, sized to the grid
+    glState.bindBuffer(GL_ARRAY_BUFFER, cannonInstanceVBO);
+    cannonInstanceCapacity = cells.size();
+    glBufferData(GL_ARRAY_BUFFER, cannonInstanceCapacity * sizeof(CannonInstance), nullptr, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(CannonInstance), (void*)offsetof(CannonInstance, position));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(CannonInstance), (void*)offsetof(CannonInstance, aimAtTarget));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+
+    glState.bindVertexArray(0);
 
     cannonTexture = loadTextureBlurry("cannon.png");
 
@@ -307,44 +388,47 @@ void Starship::initCannons() {
 }
 
 void Starship::renderCannons() {
+    if (cannonsDirty) updateCannonPositions();
     if (cannonCount == 0) return;
 
-    printf("renderCannons\n");
-
-    // Compute cannon angle toward cursor
-    float dirX = cursorX * aspect;
-    float dirY = cursorY;
-    float cannonAngle = atan2f(dirY, dirX) - currentRotation;
-
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glState.setBlend(true);
+    glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glUseProgram(cannonShader);
-    glBindVertexArray(cannonVAO);
+    glState.useProgram(cannonShader);
+    glState.bindVertexArray(cannonVAO);
 
-    // Set projection once
-    glUseProgram(cannonShader);
-    glUniformMatrix4fv(uProjectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    glState.bindTexture(1, cannonTexture);
 
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, cannonTexture);
-    glUniform1i(uTextureLoc, 1);
-
-    // Upload angle
-    glUniform1f(uCannonAngleLoc, cannonAngle);
-
-    // Ship rotation
-    glm::mat3 rotationMatrix = glm::mat3(glm::rotate(glm::mat4(1.0f), currentRotation, glm::vec3(0.0f, 0.0f, 1.0f)));
-    glUniformMatrix3fv(uShipRotationLoc, 1, GL_FALSE, glm::value_ptr(rotationMatrix));
+    // Angles are computed per cannon on the GPU from the cursor;
+    // projection, ship rotation and time come from the FrameData block
+    glUniform2f(uCursorLoc, cursorX * aspect, cursorY);
 
     glDrawArraysInstanced(GL_TRIANGLES, 0, 6, cannonCount);
-    glBindVertexArray(0);
 }
 
 void Starship::setAspect(float aspect) {
     this->aspect = aspect;
 }
 
+void Starship::setGridSize(int width, int height) {
+    gridWidth = std::max(width, 1);
+    gridHeight = std::max(height, 1);
+
+    // Keep the ship's on-screen extent, cells shrink as the grid grows
+    cellSize = shipSize / std::max(gridWidth, gridHeight);
+    originX = -(gridWidth * cellSize) / 2.0f;
+    originY = -(gridHeight * cellSize) / 2.0f;
+
+    // All cells are cleared; GPU buffers grow on their next sync
+    initStarshipCells();
+    initCellMiddlePoints();
+    cannonsDirty = true;
+
+    if (gridVAO) buildGridLines();
+    if (cellVAO) buildCellTriangle();
+    if (cannonVAO) buildCannonQuad();
+}
+
 void Starship::initCellRendering() {
     // Compile shader
     GLuint vert = compileShader(GL_VERTEX_SHADER, cellVertexShader);
@@ -355,80 +439,84 @@ void Starship::initCellRendering() {
     glLinkProgram(cellShader);
     glDeleteShader(vert);
     glDeleteShader(frag);
+    FrameData::bindProgram(cellShader);
     
     // Get uniform locations
-    transformsLoc = glGetUniformLocation(cellShader, "uTransforms");
-    texCoordsLoc = glGetUniformLocation(cellShader, "uTexCoords");
-    colorsLoc = glGetUniformLocation(cellShader, "uColors");
-    projectionLoc = glGetUniformLocation(cellShader, "uProjection");
-    shipRotationLoc = glGetUniformLocation(cellShader, "uShipRotation");
-    atlasLoc = glGetUniformLocation(cellShader, "uAtlas");
-    atlasCrackLoc = glGetUniformLocation(cellShader, "uCrackTex");
+    atlasLoc = glState.uniformLocation(cellShader, "uAtlas");
+    atlasCrackLoc = glState.uniformLocation(cellShader, "uCrackTex");
+    borderWidthLoc = glState.uniformLocation(cellShader, "uBorderWidth");
+
+    // Constant uniforms are set once here instead of every frame
+    glState.useProgram(cellShader);
+    glUniform1f(borderWidthLoc, 0.02f);
+    glUniform1i(atlasLoc, 0);
+    glUniform1i(atlasCrackLoc, 1);
     
     // Create triangle VAO/VBO
-    float half = cellSize / 2.0f;
-    float triangleVerts[] = {
-        -half, -half,
-         half, -half,
-         half,  half
-    };
-    
     glGenVertexArrays(1, &cellVAO);
     glGenBuffers(1, &cellVBO);
     
-    glBindVertexArray(cellVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, cellVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(triangleVerts), triangleVerts, GL_STATIC_DRAW);
+    glState.bindVertexArray(cellVAO);
+    buildCellTriangle();
     
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
+
+    // Per-instance buffer, one CellInstance per grid triangle
+    glGenBuffers(1, &cellInstanceVBO);
+    glState.bindBuffer(GL_ARRAY_BUFFER, cellInstanceVBO);
+    cellInstanceCapacity = cellInstances.size();
+    glBufferData(GL_ARRAY_BUFFER, cellInstanceCapacity * sizeof(CellInstance), cellInstances.data(), GL_DYNAMIC_DRAW);
+    cellsDirtyBegin = cellsDirtyEnd = 0;
+
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(CellInstance), (void*)offsetof(CellInstance, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(CellInstance), (void*)offsetof(CellInstance, atlasRect));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(CellInstance), (void*)offsetof(CellInstance, color));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
     
-    glBindVertexArray(0);
+    glState.bindVertexArray(0);
     
     // Load atlas texture
     cellAtlasTexture = loadTexture("atlas.png");
     crackAtlasTexture = loadTexture("crack_mask.png");
-    printf("crack texture ID: %u\n", crackAtlasTexture);
+    LOG_DEBUG(LOG_ASSET, "crack texture ID: %u\n", crackAtlasTexture);
+}
+
+void Starship::buildCellTriangle() {
+    float half = cellSize / 2.0f;
+    float triangleVerts[] = {
+        -half, -half,
+         half, -half,
+         half,  half
+    };
+
+    glState.bindBuffer(GL_ARRAY_BUFFER, cellVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(triangleVerts), triangleVerts, GL_STATIC_DRAW);
 }
 
 void Starship::drawCells() {
-    if(cells.empty()) return;
-    
-    glUseProgram(cellShader);
+    if(cellInstances.empty()) return;
 
-    float borderWidth = 0.02;
-    glUniform1f(glGetUniformLocation(cellShader, "uBorderWidth"), borderWidth);
+    syncCellInstances();
     
-    // Projection
-    extern glm::mat4 projection;
-    glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
-    
-    // Ship rotation
-    float c = cosf(currentRotation);
-    float s = sinf(currentRotation);
-    float rotationMatrix[9] = {
-        c,  s,  0.0f,
-       -s,  c,  0.0f,
-        0.0f, 0.0f, 1.0f
-    };
-    glUniformMatrix3fv(shipRotationLoc, 1, GL_FALSE, rotationMatrix);
-
-    glUniform1f(glGetUniformLocation(cellShader, "uTime"), emscripten_get_now() / 1000.0f);
+    glState.setBlend(true);
+    glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glState.useProgram(cellShader);
     
     // Bind atlas
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, cellAtlasTexture);
-    glUniform1i(atlasLoc, 0);
+    glState.bindTexture(0, cellAtlasTexture);
 
     // Bind crack atlas
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, crackAtlasTexture);
-    glUniform1i(atlasCrackLoc, 1);
+    glState.bindTexture(1, crackAtlasTexture);
     
     // Draw
-    glBindVertexArray(cellVAO);
-    glDrawArraysInstanced(GL_TRIANGLES, 0, 3, cells.size());
-    glBindVertexArray(0);
+    glState.bindVertexArray(cellVAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 3, cellInstances.size());
 }
 
 Starship::CellTexCoords Starship::getRandomAtlasCoords(AtlasSprite sprite, int cellNumber) {
@@ -478,87 +566,116 @@ Starship::CellTexCoords Starship::getRandomAtlasCoords(AtlasSprite sprite, int c
 }
 
 
-void Starship::updateCellUniforms() {
-    if(cells.empty()) return;
-    
-    glUseProgram(cellShader);
-    
-    std::vector<glm::mat4> transforms(cells.size());
-    std::vector<glm::vec2> texCoords(cells.size() * 3);
-    std::vector<glm::vec4> colors(cells.size());
-    
-    int aliveCount = 0;
+glm::vec2 Starship::cellPosition(int index) const {
+    // Both triangles in a pair share the same square center
+    int pairIndex = index / 2;
+    int row = pairIndex / gridWidth;
+    int column = pairIndex % gridWidth;
 
-    for(size_t i = 0; i < cells.size(); ++i) {
-        if(cells[i].cellAlive) {
-            transforms[aliveCount] = cells[i].transform;
-            
-            texCoords[aliveCount * 3 + 0] = glm::vec2(cells[i].texCoords.u0, cells[i].texCoords.v0);
-            texCoords[aliveCount * 3 + 1] = glm::vec2(cells[i].texCoords.u1, cells[i].texCoords.v1);
-            texCoords[aliveCount * 3 + 2] = glm::vec2(cells[i].texCoords.u2, cells[i].texCoords.v2);
-            
-            colors[aliveCount] = glm::vec4(cells[i].color.r, cells[i].color.g, cells[i].color.b, cells[i].color.a);
+    return glm::vec2(originX + column * cellSize + cellSize / 2.0f,
+                     -originY - cellSize - row * cellSize + cellSize / 2.0f);
+}
 
-            aliveCount += 1;
-        }
+void Starship::updateCellInstance(int index) {
+    CellInstance& instance = cellInstances[index];
+
+    instance.position = cellPosition(index);
+    instance.rotation = cells.rotated[index] ? glm::radians(180.0f) : 0.0f;
+    instance.visible = cells.isAlive(index) ? 1.0f : 0.0f;
+
+    // Grow the dirty range, uploaded once by syncCellInstances()
+    if(cellsDirtyBegin == cellsDirtyEnd) {
+        cellsDirtyBegin = index;
+        cellsDirtyEnd = index + 1;
+    } else {
+        cellsDirtyBegin = std::min(cellsDirtyBegin, index);
+        cellsDirtyEnd = std::max(cellsDirtyEnd, index + 1);
     }
-    
-    glUniformMatrix4fv(transformsLoc, aliveCount, GL_FALSE, glm::value_ptr(transforms[0]));
-    glUniform2fv(texCoordsLoc, aliveCount * 3, glm::value_ptr(texCoords[0]));
-    glUniform4fv(colorsLoc, aliveCount, glm::value_ptr(colors[0]));
+}
+
+void Starship::syncCellInstances() {
+    if(cellInstanceVBO == 0) return;
+
+    glState.bindBuffer(GL_ARRAY_BUFFER, cellInstanceVBO);
+
+    // Grid was rebuilt with more cells than the buffer holds
+    if(cellInstances.size() > cellInstanceCapacity) {
+        cellInstanceCapacity = cellInstances.size();
+        glBufferData(GL_ARRAY_BUFFER, cellInstanceCapacity * sizeof(CellInstance), cellInstances.data(), GL_DYNAMIC_DRAW);
+        cellsDirtyBegin = cellsDirtyEnd = 0;
+        return;
+    }
+
+    if(cellsDirtyBegin == cellsDirtyEnd) return;
+
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    cellsDirtyBegin * sizeof(CellInstance),
+                    (cellsDirtyEnd - cellsDirtyBegin) * sizeof(CellInstance),
+                    &cellInstances[cellsDirtyBegin]);
+    cellsDirtyBegin = cellsDirtyEnd = 0;
 }
 
 void Starship::newAttackCell(CellName name, int cellNumber) {
-    TriangleCell newCell;
-    newCell.middleOfTriangle = cells[cellNumber-1].middleOfTriangle; // get back old state, then overwrite
-    newCell.category = CellCategory::CELL_ATTACK;
-    newCell.name = name;
-    newCell.cellAlive = true;
-    newCell.cellNumber = cellNumber;
-
-    // calculate x,y translate (row column) via cellNumber over grid
-    int pairIndex = (cellNumber - 1) / 2; // which square cell
-    int row = pairIndex / gridWidth;
-    int column = pairIndex % gridWidth;
+    setCell(name, cellNumber);
+}
+
+Starship::CellCategory Starship::categoryOf(CellName name) {
+    if(name <= CELL_RAPID_FIRE_PROJECTILE) return CELL_ATTACK;
+    if(name <= CELL_FORCE_BUBBLE) return CELL_DEFENSE;
+    if(name <= CELL_ENERGY_CORE) return CELL_UTILITY;
+    if(name <= CELL_STABILIZER_JET) return CELL_JET;
+    return CELL_CUSTOM;
+}
+
+void Starship::beginEdit() {
+    editDepth++;
+}
 
-    // Both triangles in a pair share the same center position
-    newCell.x = originX + column * cellSize + cellSize / 2.0f;
-    newCell.y = -originY - cellSize - row * cellSize + cellSize / 2.0f;
+void Starship::commitEdits() {
+    if(editDepth == 0) return;
+    editDepth--;
 
-    glm::mat4 translate = glm::translate(glm::mat4(1.0f), glm::vec3(newCell.x, newCell.y, 0.0f));
-    glm::mat4 rotate = glm::mat4(1.0f);
-    if(cellNumber % 2 == 1) {
-        rotate = glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    // Cannon positions depend on the whole set of live cells, rebuild them once
+    if(editDepth == 0) {
+        cannonsDirty = true;
     }
+}
+
+void Starship::setCell(CellName name, int cellNumber) {
+    if(cellNumber < 1 || cellNumber > cells.size()) return;
 
-    newCell.transform = translate * rotate;
+    // cells are stored by cellNumber - 1
+    int index = cellNumber - 1;
+
+    cells.setAlive(index, true);
+    cells.rotated[index] = cellNumber % 2 == 1;
+    cells.category[index] = categoryOf(name);
+    cells.name[index] = name;
+    cells.stats[index] = CellStats{};
+
+    CellInstance& instance = cellInstances[index];
 
     if(name == CellName::CELL_FIRE) {
-        newCell.spriteName = ATLAS_FIRE;
-        newCell.texCoords = getRandomAtlasCoords(ATLAS_FIRE, cellNumber);
-        newCell.color = {1.0f, 0.5f, 0.2f, 1.0f};  // orange
+        cells.sprite[index] = ATLAS_FIRE;
+        instance.color = {1.0f, 0.5f, 0.2f, 1.0f};  // orange
     }
     else if (name == CellName::CELL_ICE) {
-        newCell.spriteName = ATLAS_ICE;
-        newCell.texCoords = getRandomAtlasCoords(ATLAS_ICE, cellNumber);
-        newCell.color = {0.2f, 0.6f, 1.0f, 1.0f};  // blue
+        cells.sprite[index] = ATLAS_ICE;
+        instance.color = {0.2f, 0.6f, 1.0f, 1.0f};  // blue
     }
     else if(name == CellName::CELL_RADIOACTIVE) {
-        newCell.spriteName = ATLAS_RADIOACTIVE;
-        newCell.texCoords = getRandomAtlasCoords(ATLAS_RADIOACTIVE, cellNumber);
-        newCell.color = {0.2f, 1.0f, 0.2f, 1.0f};  // green
-    }
-    
-    // replace cell in cells vector
-    for(int i = 0; i < cells.size(); ++i) {
-        if(cells[i].cellNumber == cellNumber) {
-            cells[i] = newCell;
-            break;
-        }
+        cells.sprite[index] = ATLAS_RADIOACTIVE;
+        instance.color = {0.2f, 1.0f, 0.2f, 1.0f};  // green
     }
 
-    // Update uniforms after adding/replacing cell
-    updateCellUniforms();
+    CellTexCoords texCoords = getRandomAtlasCoords((AtlasSprite)cells.sprite[index], cellNumber);
+    instance.atlasRect = glm::vec4(texCoords.u0, texCoords.v0, texCoords.u1, texCoords.v2);
+
+    updateCellInstance(index);
+
+    if(editDepth == 0) {
+        cannonsDirty = true;
+    }
 }
 
 void Starship::initCellMiddlePoints() {
@@ -573,14 +690,14 @@ void Starship::initCellMiddlePoints() {
 
             // Bottom-right triangle: vertices (x0,y0), (x1,y0), (x1,y1)
             int cellNum0 = baseCellNumber + 1;
-            cells[cellNum0].middleOfTriangle = glm::vec2(
+            cells.center[cellNum0] = glm::vec2(
                 (x0 + x1 + x1) / 3.0f,  // x is left + right + right / 3
                 (y0 + y0 + y1) / 3.0f  // y is bottom + bottom + top / 3
             );
 
             // Top-left triangle: vertices (x0,y0), (x1,y1), (x0,y1)
             int cellNum1 = baseCellNumber;
-            cells[cellNum1].middleOfTriangle = glm::vec2(
+            cells.center[cellNum1] = glm::vec2(
                 (x0 + x0 + x1) / 3.0f,
                 (y0 + y1 + y1) / 3.0f
             );
@@ -591,16 +708,40 @@ void Starship::initCellMiddlePoints() {
 void Starship::initStarshipCells() {
     int totalTriangles = gridWidth * gridHeight * 2;
 
-    cells.resize(0);
+    cells.resize(totalTriangles);
+
+    // Every slot starts hidden; the whole buffer is re-uploaded on next sync
+    cellInstances.assign(totalTriangles, CellInstance{});
+    cannonStates.assign(totalTriangles, CannonState{glm::vec2(0.0f), false, -1000.0f, 1.0f});
+    cellsDirtyBegin = 0;
+    cellsDirtyEnd = totalTriangles;
+}
+
+void Starship::CellStore::resize(int count) {
+    aliveBits.assign((count + 63) / 64, 0);
+    center.assign(count, glm::vec2(0.0f));
+    rotated.assign(count, 0);
+    sprite.assign(count, 0);
+    category.assign(count, CELL_ATTACK);
+    name.assign(count, CELL_FIRE);
+    stats.assign(count, CellStats{});
+}
 
-    for(int i = 1; i < totalTriangles + 1; ++i) {
-        TriangleCell newCell;
-        newCell.cellAlive = false;
-        newCell.cellNumber = i;
-        cells.push_back(newCell);
+void Starship::CellStore::setAlive(int index, bool alive) {
+    uint64_t mask = uint64_t(1) << (index & 63);
+    if (alive) {
+        aliveBits[index >> 6] |= mask;
+    } else {
+        aliveBits[index >> 6] &= ~mask;
     }
 }
 
+int Starship::CellStore::aliveCount() const {
+    int count = 0;
+    forEachAlive([&](int) { count++; });
+    return count;
+}
+
 void Starship::initGrid() {
     // Create shader program
     GLuint vert = compileShader(GL_VERTEX_SHADER, gridVertexShader);
@@ -611,12 +752,25 @@ void Starship::initGrid() {
     glLinkProgram(gridShader);
     glDeleteShader(vert);
     glDeleteShader(frag);
+    FrameData::bindProgram(gridShader);
 
-    rotationUniformLoc = glGetUniformLocation(gridShader, "uRotation");
-    projectionUniformLoc = glGetUniformLocation(gridShader, "uProjection");
+    // Create VAO/VBO
+    glGenVertexArrays(1, &gridVAO);
+    glGenBuffers(1, &gridVBO);
+
+    glState.bindVertexArray(gridVAO);
+    buildGridLines();
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
 
+    glState.bindVertexArray(0);
+}
+
+void Starship::buildGridLines() {
     // Build line vertices
     std::vector<float> vertices;
+    vertices.reserve(((gridWidth + 1) + (gridHeight + 1) + gridWidth * gridHeight) * 4);
 
     // 1. Vertical lines
     for (int i = 0; i <= gridWidth; i++) {
@@ -650,43 +804,20 @@ void Starship::initGrid() {
 
     gridVertexCount = vertices.size() / 2;
 
-    // Create VAO/VBO
-    glGenVertexArrays(1, &gridVAO);
-    glGenBuffers(1, &gridVBO);
-
-    glBindVertexArray(gridVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, gridVBO);
+    glState.bindBuffer(GL_ARRAY_BUFFER, gridVBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glBindVertexArray(0);
 }
 
 void Starship::drawGrid() {
-    glUseProgram(gridShader);
-
-    float c = cosf(currentRotation);
-    float s = sinf(currentRotation);
-    float rotationMatrix[9] = {
-        c,  s,  0.0f,
-       -s,  c,  0.0f,
-        0.0f, 0.0f, 1.0f
-    };
-
-    glUniformMatrix3fv(rotationUniformLoc, 1, GL_FALSE, rotationMatrix);
-    glUniformMatrix4fv(projectionUniformLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-    glBindVertexArray(gridVAO);
+    glState.useProgram(gridShader);
+    glState.bindVertexArray(gridVAO);
     glDrawArrays(GL_LINES, 0, gridVertexCount);
-    glBindVertexArray(0);
 }
 
 void Starship::cleanupGrid() {
-    if (gridVAO) glDeleteVertexArrays(1, &gridVAO);
-    if (gridVBO) glDeleteBuffers(1, &gridVBO);
-    if (gridShader) glDeleteProgram(gridShader);
+    if (gridVAO) glState.deleteVertexArray(gridVAO);
+    if (gridVBO) glState.deleteBuffer(gridVBO);
+    if (gridShader) glState.deleteProgram(gridShader);
     gridVAO = gridVBO = gridShader = 0;
 }
 
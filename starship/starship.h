@@ -2,6 +2,9 @@
 
 #include <vector>
 #include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 #include <GLES3/gl3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -103,31 +106,94 @@ public:
         ATLAS_RADIOACTIVE = 2,
     };
 
-    struct TriangleCell {
-        CellCategory category;
-        CellName name;
-        bool cellAlive;
-        int cellNumber;
-        glm::vec2 middleOfTriangle;
-        glm::mat4 transform;
-        float x, y;
-        CellTexCoords texCoords;
-        AtlasSprite spriteName;
+    union CellStats {
+        DefenseData defense;
+        AttackData attack;
+        UtilityData utility;
+        JetData jet;
+        CustomData custom;
+    };
+
+    // Structure-of-arrays cell storage, indexed by cellNumber - 1.
+    // Hot arrays are read by per-frame passes, cold arrays only on edits.
+    // Transforms are derived from the index (see cellPosition()).
+    struct CellStore {
+        // Hot
+        std::vector<uint64_t> aliveBits;
+        std::vector<glm::vec2> center;     // middle of triangle
+        std::vector<uint8_t> rotated;      // odd cell numbers are turned 180 degrees
+        std::vector<uint8_t> sprite;       // AtlasSprite
+
+        // Cold
+        std::vector<CellCategory> category;
+        std::vector<CellName> name;
+        std::vector<CellStats> stats;
+
+        void resize(int count);
+        int size() const { return (int)center.size(); }
+        bool empty() const { return center.empty(); }
+        bool isAlive(int index) const { return (aliveBits[index >> 6] >> (index & 63)) & 1; }
+        void setAlive(int index, bool alive);
+        int aliveCount() const;
+
+        // Calls fn(index) for every live cell, skipping dead words of the bitset
+        template<typename Fn>
+        void forEachAlive(Fn fn) const {
+            for (size_t word = 0; word < aliveBits.size(); ++word) {
+                uint64_t bits = aliveBits[word];
+                while (bits) {
+                    fn((int)(word * 64 + countTrailingZeros(bits)));
+                    bits &= bits - 1;
+                }
+            }
+        }
+
+        static int countTrailingZeros(uint64_t bits) {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward64(&index, bits);
+            return (int)index;
+#else
+            return __builtin_ctzll(bits);
+#endif
+        }
+    };
+
+    // Packed per-instance record streamed to cellInstanceVBO, one slot per grid triangle
+    struct CellInstance {
+        glm::vec2 position;
+        float rotation;
+        float visible;
+        glm::vec4 atlasRect;  // u0, v0, u1, v2 (see getRandomAtlasCoords)
         glm::vec4 color;
-        union {
-            DefenseData defense;
-            AttackData attack;
-            UtilityData utility;
-            JetData jet;
-            CustomData custom;
-        };
     };
 
-    std::vector<TriangleCell> cells;
+    // Aiming and firing state of the cannon on each cell, indexed like cells
+    struct CannonState {
+        glm::vec2 target;      // ship-local aim point, used when aimAtTarget is set
+        bool aimAtTarget;      // false = follow the cursor
+        float lastFired;       // seconds, same clock as uTime
+        float cooldown;        // seconds until the barrel is back in place
+    };
+
+    // Packed per-instance record streamed to cannonInstanceVBO, live cannons only.
+    // The angle is computed per cannon in the vertex shader.
+    struct CannonInstance {
+        glm::vec2 position;
+        glm::vec2 target;
+        float aimAtTarget;
+        float lastFired;
+        float cooldown;
+        float pad;
+    };
+
+    CellStore cells;
+    std::vector<CellInstance> cellInstances;
 
-    // Grid settings
+    // Grid settings, change at runtime with setGridSize()
     int gridWidth = 9;
     int gridHeight = 9;
+    float shipSize = 1.08f;   // world-space length of the longer grid side
     float cellSize = 0.120;
     float originX = -(gridWidth*cellSize)/2.0;
     float originY = -(gridHeight*cellSize)/2.0;
@@ -136,8 +202,6 @@ public:
     GLuint gridVAO = 0;
     GLuint gridVBO = 0;
     GLuint gridShader = 0;
-    GLint rotationUniformLoc = -1;
-    GLint projectionUniformLoc = -1;
     int gridVertexCount = 0;
 
     // Rotation state
@@ -153,31 +217,35 @@ public:
     GLuint cellShader = 0;
     GLuint cellVAO = 0;
     GLuint cellVBO = 0;
+    GLuint cellInstanceVBO = 0;
+    size_t cellInstanceCapacity = 0;
+    int cellsDirtyBegin = 0;   // dirty instance range [begin, end)
+    int cellsDirtyEnd = 0;
     GLuint cellAtlasTexture = 0;
     GLuint crackAtlasTexture = 0;
 
-    // Uniform locations
-    GLint transformsLoc = -1;
-    GLint texCoordsLoc = -1;
-    GLint colorsLoc = -1;
-    GLint projectionLoc = -1;
-    GLint shipRotationLoc = -1;
+    // Uniform locations, projection/rotation/time live in the FrameData block
     GLint atlasLoc = -1;
     GLint atlasCrackLoc = -1;
+    GLint borderWidthLoc = -1;
 
-    GLuint cannonVAO;
-    GLuint cannonVBO;
-    GLuint cannonTexture;
-    GLuint cannonShader;
-
-    // In Starship class header
-    static const int MAX_CANNONS = 256;
-    GLint uCannonPositionsLoc;
-    GLint uCannonAngleLoc;
-    GLint uShipRotationLoc;
-    GLint uProjectionLoc;
+    GLuint cannonVAO = 0;
+    GLuint cannonVBO = 0;
+    GLuint cannonInstanceVBO = 0;
+    size_t cannonInstanceCapacity = 0;
+    GLuint cannonTexture = 0;
+    GLuint cannonShader = 0;
+    std::vector<CannonState> cannonStates;
+    std::vector<CannonInstance> cannonInstances;
+
+    GLint uCursorLoc;
+    GLint uRecoilLoc;
     GLint uTextureLoc;
     int cannonCount = 0;
+    bool cannonsDirty = false;
+
+    // Batched cell edits, see beginEdit()/commitEdits()
+    int editDepth = 0;
 
     float cursorX = 0;
     float cursorY = 0;
@@ -190,18 +258,34 @@ public:
     CellTexCoords getRandomAtlasCoords(AtlasSprite sprite, int cellNumber);
     
     void setAspect(float aspect);
+    void setGridSize(int width, int height);
     void updateCannonPositions();
+    void buildCannonQuad();
     void initCannons();
     void renderCannons();
+    void setCannonTarget(int cellNumber, glm::vec2 target);
+    void clearCannonTarget(int cellNumber);
+    void fireCannon(int cellNumber, float cooldown);
     void initCellMiddlePoints();
     void initStarshipCells();
 
     void initCellRendering();
-    void updateCellUniforms();
+    void buildCellTriangle();
+    glm::vec2 cellPosition(int index) const;
+    void updateCellInstance(int index);
+    void syncCellInstances();
     void newAttackCell(CellName name, int cellNumber);
+
+    // Cell edits between beginEdit() and commitEdits() only touch CPU-side
+    // state; GPU buffers are synced at most once per frame by the draw calls.
+    void beginEdit();
+    void setCell(CellName name, int cellNumber);
+    void commitEdits();
+    static CellCategory categoryOf(CellName name);
     void drawCells();
 
     void initGrid();
+    void buildGridLines();
     void drawGrid();
     void cleanupGrid();
 
@@ -0,0 +1,656 @@
+// FontAtlas.cpp
+#include "fontAtlas.h"
+#include "logger/logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#ifndef TEXT_RENDERER_NO_FREETYPE
+#include FT_GLYPH_H
+#include FT_MODULE_H
+#include FT_TRUETYPE_TABLES_H
+#include FT_TRUETYPE_TAGS_H
+
+// FT_RENDER_MODE_SDF arrived in FreeType 2.11
+#if FREETYPE_MAJOR > 2 || (FREETYPE_MAJOR == 2 && FREETYPE_MINOR >= 11)
+#define FONT_ATLAS_HAS_SDF 1
+#else
+#define FONT_ATLAS_HAS_SDF 0
+#endif
+#endif
+
+// .font layout: FileHeader, glyphCount FontGlyph records, pixelBytes of R8
+// pixels (raw or PackBits), then a uint32 count of KerningPair records.
+// Little-endian, which covers wasm and x86/ARM.
+static const char FONT_MAGIC[4] = {'T', 'S', 'F', 'A'};
+static const uint32_t FONT_VERSION = 3;   // 2: texel TexCoords, shelf packed; 3: kerning
+static const uint32_t FONT_MIN_VERSION = 2;
+
+enum : uint32_t {
+    COMPRESSION_NONE = 0,
+    COMPRESSION_PACKBITS = 1
+};
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t mode;
+    uint32_t pixelSize;
+    uint32_t width, height;
+    uint32_t glyphCount;
+    uint32_t compression;
+    uint32_t pixelBytes;
+};
+
+static_assert(sizeof(FontGlyph) == 56, "FontGlyph is written to disk as-is");
+static_assert(sizeof(FileHeader) == 36, "FileHeader is written to disk as-is");
+static_assert(sizeof(KerningPair) == 8, "KerningPair is written to disk as-is");
+
+// PackBits: a control byte n in 0..127 is followed by n+1 literal bytes,
+// n in 129..255 repeats the next byte 257-n times. Atlases are mostly empty
+// cells, the long zero runs are where the savings come from.
+static void packBits(const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+    out.clear();
+    size_t i = 0;
+    while (i < in.size()) {
+        size_t run = 1;
+        while (i + run < in.size() && run < 128 && in[i + run] == in[i]) run++;
+
+        if (run >= 3) {
+            out.push_back(static_cast<uint8_t>(257 - run));
+            out.push_back(in[i]);
+            i += run;
+            continue;
+        }
+
+        // Literal block up to the next run of three
+        size_t start = i;
+        size_t count = 0;
+        while (i < in.size() && count < 128) {
+            if (i + 2 < in.size() && in[i] == in[i + 1] && in[i] == in[i + 2]) break;
+            i++;
+            count++;
+        }
+        out.push_back(static_cast<uint8_t>(count - 1));
+        out.insert(out.end(), in.begin() + start, in.begin() + start + count);
+    }
+}
+
+static bool unpackBits(const uint8_t* in, size_t inSize, uint8_t* out, size_t outSize) {
+    size_t i = 0, o = 0;
+    while (i < inSize && o < outSize) {
+        uint8_t control = in[i++];
+        if (control < 128) {
+            size_t count = control + 1;
+            if (i + count > inSize || o + count > outSize) return false;
+            memcpy(out + o, in + i, count);
+            i += count;
+            o += count;
+        } else if (control > 128) {
+            size_t count = 257 - control;
+            if (i >= inSize || o + count > outSize) return false;
+            memset(out + o, in[i++], count);
+            o += count;
+        }
+    }
+    return o == outSize;
+}
+
+// Glyph rects are cut out of the pixels as they are, so they must be whole
+// texels inside the atlas
+static bool glyphInAtlas(const FontGlyph& glyph, uint32_t width, uint32_t height) {
+    if (!glyph.Present) return true;
+    glm::vec2 low = glyph.TexCoords[0], high = glyph.TexCoords[1];
+    if (low.x != std::floor(low.x) || low.y != std::floor(low.y) ||
+        high.x != std::floor(high.x) || high.y != std::floor(high.y)) {
+        return false;
+    }
+    return low.x >= 0.0f && low.x <= high.x && high.x <= static_cast<float>(width) &&
+           low.y >= 0.0f && low.y <= high.y && high.y <= static_cast<float>(height);
+}
+
+bool loadFontAtlas(const char* path, FontAtlas& atlas) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    FileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, FONT_MAGIC, sizeof(FONT_MAGIC)) != 0) {
+        fclose(file);
+        return false;
+    }
+
+    if (header.version < FONT_MIN_VERSION || header.version > FONT_VERSION || header.glyphCount != FontAtlas::GLYPH_COUNT ||
+        header.pixelSize != FontAtlas::PIXEL_SIZE || header.mode > FontAtlas::ATLAS_SDF ||
+        header.width == 0 || header.height == 0 || header.width > 8192 || header.height > 8192) {
+        LOG_ERROR(LOG_ASSET, "Font atlas %s: unsupported version %u or layout\n", path, header.version);
+        fclose(file);
+        return false;
+    }
+
+    // Sized from the header, so check it before allocating: raw pixels are
+    // exactly width * height, PackBits adds a control byte per 128 at worst
+    size_t pixelCount = static_cast<size_t>(header.width) * header.height;
+    size_t maxStored = header.compression == COMPRESSION_PACKBITS ? pixelCount + (pixelCount + 127) / 128 : pixelCount;
+    if ((header.compression != COMPRESSION_NONE && header.compression != COMPRESSION_PACKBITS) ||
+        header.pixelBytes > maxStored) {
+        LOG_ERROR(LOG_ASSET, "Font atlas %s: bad pixel size %u\n", path, header.pixelBytes);
+        fclose(file);
+        return false;
+    }
+
+    std::vector<uint8_t> stored(header.pixelBytes);
+    bool ok = fread(atlas.glyphs, sizeof(FontGlyph), FontAtlas::GLYPH_COUNT, file) == FontAtlas::GLYPH_COUNT &&
+              fread(stored.data(), 1, stored.size(), file) == stored.size();
+    for (int c = 0; ok && c < FontAtlas::GLYPH_COUNT; c++) {
+        ok = glyphInAtlas(atlas.glyphs[c], header.width, header.height);
+    }
+
+    // Version 2 blobs have no kerning, text just sets without it
+    atlas.kerning.clear();
+    uint32_t kerningCount = 0;
+    if (ok && header.version >= 3) {
+        ok = fread(&kerningCount, sizeof(kerningCount), 1, file) == 1 &&
+             kerningCount <= FontAtlas::GLYPH_COUNT * FontAtlas::GLYPH_COUNT;
+        if (ok) {
+            atlas.kerning.resize(kerningCount);
+            ok = fread(atlas.kerning.data(), sizeof(KerningPair), kerningCount, file) == kerningCount;
+        }
+    }
+    fclose(file);
+
+    atlas.mode = static_cast<FontAtlas::Mode>(header.mode);
+    atlas.width = static_cast<int>(header.width);
+    atlas.height = static_cast<int>(header.height);
+
+    if (ok && header.compression == COMPRESSION_PACKBITS) {
+        atlas.pixels.resize(pixelCount);
+        ok = unpackBits(stored.data(), stored.size(), atlas.pixels.data(), pixelCount);
+    } else if (ok && header.compression == COMPRESSION_NONE && stored.size() == pixelCount) {
+        atlas.pixels.swap(stored);
+    } else {
+        ok = false;
+    }
+
+    if (!ok) {
+        LOG_ERROR(LOG_ASSET, "Font atlas %s is truncated or corrupt\n", path);
+        // Callers fall back to other fonts with the same atlas, leave no
+        // half-read glyphs in it
+        atlas = FontAtlas();
+        return false;
+    }
+
+    LOG_INFO(LOG_ASSET, "Loaded font atlas: %s (%dx%d %s, %zu kerning pairs)\n", path, atlas.width, atlas.height,
+             atlas.mode == FontAtlas::ATLAS_SDF ? "SDF" : "bitmap", atlas.kerning.size());
+    return true;
+}
+
+bool saveFontAtlas(const char* path, const FontAtlas& atlas, bool compress) {
+    std::vector<uint8_t> packed;
+    if (compress) packBits(atlas.pixels, packed);
+    const std::vector<uint8_t>& stored = compress ? packed : atlas.pixels;
+
+    FileHeader header;
+    memcpy(header.magic, FONT_MAGIC, sizeof(FONT_MAGIC));
+    header.version = FONT_VERSION;
+    header.mode = atlas.mode;
+    header.pixelSize = FontAtlas::PIXEL_SIZE;
+    header.width = atlas.width;
+    header.height = atlas.height;
+    header.glyphCount = FontAtlas::GLYPH_COUNT;
+    header.compression = compress ? COMPRESSION_PACKBITS : COMPRESSION_NONE;
+    header.pixelBytes = static_cast<uint32_t>(stored.size());
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        LOG_ERROR(LOG_ASSET, "Cannot write font atlas %s\n", path);
+        return false;
+    }
+
+    uint32_t kerningCount = static_cast<uint32_t>(atlas.kerning.size());
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(atlas.glyphs, sizeof(FontGlyph), FontAtlas::GLYPH_COUNT, file) == FontAtlas::GLYPH_COUNT &&
+              fwrite(stored.data(), 1, stored.size(), file) == stored.size() &&
+              fwrite(&kerningCount, sizeof(kerningCount), 1, file) == 1 &&
+              fwrite(atlas.kerning.data(), sizeof(KerningPair), kerningCount, file) == kerningCount;
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok) {
+        LOG_ERROR(LOG_ASSET, "Writing font atlas %s failed\n", path);
+    }
+    return ok;
+}
+
+#ifndef TEXT_RENDERER_NO_FREETYPE
+
+// SDF glyphs are rendered at this size and scaled up to PIXEL_SIZE; the
+// spread is the distance range in raster pixels on each side of the edge
+static const int SDF_PIXEL_SIZE = 32;
+static const int SDF_SPREAD = 4;
+
+// The only face the manager ever asks for, face ids are the rasterizer itself
+FT_Error GlyphRasterizer::requestFace(FTC_FaceID faceId, FT_Library library, FT_Pointer, FT_Face* face) {
+    GlyphRasterizer* self = static_cast<GlyphRasterizer*>(faceId);
+    return FT_New_Face(library, self->path.c_str(), 0, face);
+}
+
+GlyphRasterizer::~GlyphRasterizer() {
+    close();
+}
+
+void GlyphRasterizer::close() {
+    if (manager) FTC_Manager_Done(manager);
+    if (library) FT_Done_FreeType(library);
+    manager = nullptr;
+    library = nullptr;
+    cmapCache = nullptr;
+    imageCache = nullptr;
+    hasKernTable = false;
+    unitsPerEm = 0;
+    gpos.clear();
+    kernSubtables.clear();
+}
+
+static void copyBitmap(const FT_Bitmap& source, int left, int top, GlyphBitmap& bitmap) {
+    bitmap.width = source.width;
+    bitmap.rows = source.rows;
+    bitmap.left = left;
+    bitmap.top = top;
+    bitmap.pixels.clear();
+    for (int row = 0; row < bitmap.rows; row++) {
+        const uint8_t* src = source.buffer + row * source.pitch;
+        bitmap.pixels.insert(bitmap.pixels.end(), src, src + bitmap.width);
+    }
+}
+
+bool GlyphRasterizer::open(const char* fontPath, FontAtlas::Mode requestedMode) {
+    close();
+    path = fontPath;
+
+    if (FT_Init_FreeType(&library)) {
+        library = nullptr;
+        return false;
+    }
+
+    // One face, two sizes (layout metrics and SDF raster); glyph images are
+    // only kept until they are in the atlas, 1 MB is plenty
+    if (FTC_Manager_New(library, 1, 2, 1 << 20, requestFace, nullptr, &manager) ||
+        FTC_CMapCache_New(manager, &cmapCache) ||
+        FTC_ImageCache_New(manager, &imageCache)) {
+        close();
+        return false;
+    }
+
+    FT_Face face;
+    if (FTC_Manager_LookupFace(manager, this, &face)) {
+        LOG_ERROR(LOG_ASSET, "Failed to load font: %s\n", fontPath);
+        close();
+        return false;
+    }
+    loadKerning(face);
+
+    mode = FontAtlas::ATLAS_BITMAP;
+
+#if FONT_ATLAS_HAS_SDF
+    if (requestedMode == FontAtlas::ATLAS_SDF) {
+        FT_Int spread = SDF_SPREAD;
+        FT_Property_Set(library, "sdf", "spread", &spread);
+
+        // Probe once, the sdf module can be configured out of the library
+        FontGlyph glyph;
+        GlyphBitmap bitmap;
+        mode = FontAtlas::ATLAS_SDF;
+        if (!rasterize('A', glyph, bitmap) || bitmap.width == 0) {
+            mode = FontAtlas::ATLAS_BITMAP;
+        }
+    }
+#endif
+
+    if (mode != requestedMode) {
+        LOG_WARN(LOG_ASSET, "FreeType cannot render SDF glyphs, using a bitmap atlas\n");
+    }
+    return true;
+}
+
+bool GlyphRasterizer::rasterize(uint32_t codepoint, FontGlyph& glyph, GlyphBitmap& bitmap) {
+    if (!manager) return false;
+
+    FT_UInt index = FTC_CMapCache_Lookup(cmapCache, this, -1, codepoint);
+    if (index == 0) return false;
+
+    // Layout metrics always come from the PIXEL_SIZE raster so text measures
+    // the same in both modes
+    FTC_ScalerRec scaler = {};
+    scaler.face_id = this;
+    scaler.height = FontAtlas::PIXEL_SIZE;
+    scaler.pixel = 1;
+
+    FT_Glyph image;
+    if (FTC_ImageCache_LookupScaler(imageCache, &scaler, FT_LOAD_RENDER, index, &image, nullptr) ||
+        image->format != FT_GLYPH_FORMAT_BITMAP) {
+        return false;
+    }
+
+    FT_BitmapGlyph coverage = reinterpret_cast<FT_BitmapGlyph>(image);
+    glyph = FontGlyph();
+    glyph.Size = glm::ivec2(coverage->bitmap.width, coverage->bitmap.rows);
+    glyph.Bearing = glm::ivec2(coverage->left, coverage->top);
+    glyph.Advance = static_cast<uint32_t>(image->advance.x >> 10);   // 16.16 -> 26.6
+    glyph.Present = 1;
+
+    float quadScale = 1.0f;
+    bitmap = GlyphBitmap();
+
+    if (mode == FontAtlas::ATLAS_BITMAP) {
+        copyBitmap(coverage->bitmap, coverage->left, coverage->top, bitmap);
+    } else {
+#if FONT_ATLAS_HAS_SDF
+        scaler.height = SDF_PIXEL_SIZE;
+        quadScale = static_cast<float>(FontAtlas::PIXEL_SIZE) / SDF_PIXEL_SIZE;
+
+        FT_Glyph outline;
+        if (FTC_ImageCache_LookupScaler(imageCache, &scaler, FT_LOAD_DEFAULT, index, &outline, nullptr)) {
+            return false;
+        }
+
+        // Blank glyphs such as space have no outline to measure
+        bool blank = outline->format != FT_GLYPH_FORMAT_OUTLINE ||
+                     reinterpret_cast<FT_OutlineGlyph>(outline)->outline.n_points == 0;
+        if (!blank) {
+            // Renders into a new glyph, the cached outline stays untouched
+            FT_Glyph distance = outline;
+            if (FT_Glyph_To_Bitmap(&distance, FT_RENDER_MODE_SDF, nullptr, 0)) {
+                return false;
+            }
+            FT_BitmapGlyph sdf = reinterpret_cast<FT_BitmapGlyph>(distance);
+            copyBitmap(sdf->bitmap, sdf->left, sdf->top, bitmap);
+            FT_Done_Glyph(distance);
+        }
+#endif
+    }
+
+    glyph.QuadOffset = glm::vec2(bitmap.left, bitmap.top) * quadScale;
+    glyph.QuadSize = glm::vec2(bitmap.width, bitmap.rows) * quadScale;
+    return true;
+}
+
+// GPOS reading, just enough for pair kerning: PairPos subtables (lookup
+// type 2, or 9 wrapping it) of the 'kern' feature, all scripts. Tables are
+// big-endian; reads past the end return 0, so a damaged table only loses
+// kerning.
+static uint16_t readU16(const std::vector<uint8_t>& data, size_t offset) {
+    if (offset + 2 > data.size()) return 0;
+    return static_cast<uint16_t>(data[offset] << 8 | data[offset + 1]);
+}
+
+static uint32_t readU32(const std::vector<uint8_t>& data, size_t offset) {
+    return static_cast<uint32_t>(readU16(data, offset)) << 16 | readU16(data, offset + 2);
+}
+
+// Coverage index of a glyph, -1 when the table does not cover it
+static int coverageIndex(const std::vector<uint8_t>& data, size_t table, uint16_t glyph) {
+    uint16_t format = readU16(data, table);
+    int count = readU16(data, table + 2);
+
+    int lo = 0, hi = count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (format == 1) {
+            uint16_t id = readU16(data, table + 4 + mid * 2);
+            if (id == glyph) return mid;
+            if (id < glyph) lo = mid + 1; else hi = mid - 1;
+        } else if (format == 2) {
+            size_t range = table + 4 + mid * 6;
+            if (glyph < readU16(data, range)) {
+                hi = mid - 1;
+            } else if (glyph > readU16(data, range + 2)) {
+                lo = mid + 1;
+            } else {
+                return readU16(data, range + 4) + glyph - readU16(data, range);
+            }
+        } else {
+            break;
+        }
+    }
+    return -1;
+}
+
+static uint16_t glyphClass(const std::vector<uint8_t>& data, size_t table, uint16_t glyph) {
+    uint16_t format = readU16(data, table);
+    if (format == 1) {
+        uint16_t start = readU16(data, table + 2);
+        uint16_t count = readU16(data, table + 4);
+        return glyph >= start && glyph - start < count ? readU16(data, table + 6 + (glyph - start) * 2) : 0;
+    }
+    if (format == 2) {
+        int lo = 0, hi = readU16(data, table + 2) - 1;
+        while (lo <= hi) {
+            int mid = (lo + hi) / 2;
+            size_t range = table + 4 + mid * 6;
+            if (glyph < readU16(data, range)) {
+                hi = mid - 1;
+            } else if (glyph > readU16(data, range + 2)) {
+                lo = mid + 1;
+            } else {
+                return readU16(data, range + 4);
+            }
+        }
+    }
+    return 0;
+}
+
+// Every set bit of the low byte is one 16 bit field, device table offsets included
+static int valueRecordSize(uint16_t valueFormat) {
+    int size = 0;
+    for (int bit = 0; bit < 8; bit++) {
+        if (valueFormat & (1 << bit)) size += 2;
+    }
+    return size;
+}
+
+// XAdvance of a ValueRecord, it follows XPlacement and YPlacement when present
+static int16_t valueXAdvance(const std::vector<uint8_t>& data, size_t record, uint16_t valueFormat) {
+    if (!(valueFormat & 0x0004)) return 0;
+    return static_cast<int16_t>(readU16(data, record + valueRecordSize(valueFormat & 0x0003)));
+}
+
+// False when the subtable has nothing for the pair, the next one gets a try
+static bool pairAdjustment(const std::vector<uint8_t>& data, size_t subtable,
+                           uint16_t left, uint16_t right, int& adjust) {
+    int coverage = coverageIndex(data, subtable + readU16(data, subtable + 2), left);
+    if (coverage < 0) return false;
+
+    uint16_t format = readU16(data, subtable);
+    uint16_t valueFormat1 = readU16(data, subtable + 4);
+    uint16_t valueFormat2 = readU16(data, subtable + 6);
+    int recordSize = valueRecordSize(valueFormat1) + valueRecordSize(valueFormat2);
+
+    if (format == 1) {
+        // Pair sets per first glyph, sorted by second glyph
+        if (coverage >= readU16(data, subtable + 8)) return false;
+        size_t pairSet = subtable + readU16(data, subtable + 10 + coverage * 2);
+        int lo = 0, hi = readU16(data, pairSet) - 1;
+        while (lo <= hi) {
+            int mid = (lo + hi) / 2;
+            size_t record = pairSet + 2 + mid * (2 + recordSize);
+            uint16_t second = readU16(data, record);
+            if (second == right) {
+                adjust = valueXAdvance(data, record + 2, valueFormat1);
+                return true;
+            }
+            if (second < right) lo = mid + 1; else hi = mid - 1;
+        }
+        return false;
+    }
+
+    if (format == 2) {
+        // Class pairs, a covered first glyph always matches
+        uint16_t class1 = glyphClass(data, subtable + readU16(data, subtable + 8), left);
+        uint16_t class2 = glyphClass(data, subtable + readU16(data, subtable + 10), right);
+        uint16_t class1Count = readU16(data, subtable + 12);
+        uint16_t class2Count = readU16(data, subtable + 14);
+        if (class1 >= class1Count || class2 >= class2Count) return false;
+        size_t record = subtable + 16 + (static_cast<size_t>(class1) * class2Count + class2) * recordSize;
+        adjust = valueXAdvance(data, record, valueFormat1);
+        return true;
+    }
+    return false;
+}
+
+void GlyphRasterizer::loadKerning(FT_Face face) {
+    hasKernTable = FT_HAS_KERNING(face);
+    unitsPerEm = face->units_per_EM;
+    gpos.clear();
+    kernSubtables.clear();
+    if (hasKernTable || !FT_IS_SFNT(face)) return;
+
+    FT_ULong length = 0;
+    if (FT_Load_Sfnt_Table(face, TTAG_GPOS, 0, nullptr, &length) || length == 0) return;
+    gpos.resize(length);
+    if (FT_Load_Sfnt_Table(face, TTAG_GPOS, 0, gpos.data(), &length)) {
+        gpos.clear();
+        return;
+    }
+
+    // Lookups of every 'kern' feature, each once and in lookup list order
+    size_t featureList = readU16(gpos, 6);
+    size_t lookupList = readU16(gpos, 8);
+    std::vector<uint16_t> lookups;
+    for (int i = 0; i < readU16(gpos, featureList); i++) {
+        size_t record = featureList + 2 + i * 6;
+        if (record + 4 > gpos.size() || memcmp(&gpos[record], "kern", 4) != 0) continue;
+        size_t feature = featureList + readU16(gpos, record + 4);
+        for (int j = 0; j < readU16(gpos, feature + 2); j++) {
+            lookups.push_back(readU16(gpos, feature + 4 + j * 2));
+        }
+    }
+    std::sort(lookups.begin(), lookups.end());
+    lookups.erase(std::unique(lookups.begin(), lookups.end()), lookups.end());
+
+    for (uint16_t index : lookups) {
+        size_t lookup = lookupList + readU16(gpos, lookupList + 2 + index * 2);
+        uint16_t type = readU16(gpos, lookup);
+        for (int j = 0; j < readU16(gpos, lookup + 4); j++) {
+            size_t subtable = lookup + readU16(gpos, lookup + 6 + j * 2);
+            if (type == 9 && readU16(gpos, subtable + 2) == 2) {
+                subtable += readU32(gpos, subtable + 4);
+            } else if (type != 2) {
+                continue;
+            }
+            kernSubtables.push_back({index, static_cast<uint32_t>(subtable)});
+        }
+    }
+
+    if (kernSubtables.empty()) gpos.clear();
+}
+
+int32_t GlyphRasterizer::kerning(uint32_t left, uint32_t right) {
+    if (!manager || !unitsPerEm || (!hasKernTable && kernSubtables.empty())) return 0;
+
+    FT_UInt leftIndex = FTC_CMapCache_Lookup(cmapCache, this, -1, left);
+    FT_UInt rightIndex = FTC_CMapCache_Lookup(cmapCache, this, -1, right);
+    if (leftIndex == 0 || rightIndex == 0) return 0;
+
+    // Font units either way
+    long units = 0;
+    if (hasKernTable) {
+        FT_Face face;
+        FT_Vector delta;
+        if (FTC_Manager_LookupFace(manager, this, &face) ||
+            FT_Get_Kerning(face, leftIndex, rightIndex, FT_KERNING_UNSCALED, &delta)) {
+            return 0;
+        }
+        units = delta.x;
+    } else {
+        int lastLookup = -1;
+        for (const KernSubtable& subtable : kernSubtables) {
+            if (subtable.lookup == lastLookup) continue;
+            int adjust;
+            if (pairAdjustment(gpos, subtable.offset, static_cast<uint16_t>(leftIndex),
+                               static_cast<uint16_t>(rightIndex), adjust)) {
+                units += adjust;
+                lastLookup = subtable.lookup;
+            }
+        }
+    }
+
+    // To 26.6 at PIXEL_SIZE, rounded
+    long scaled = units * FontAtlas::PIXEL_SIZE * 64;
+    return static_cast<int32_t>((scaled + (scaled < 0 ? -unitsPerEm : unitsPerEm) / 2) / unitsPerEm);
+}
+
+bool bakeFontAtlas(const char* fontPath, FontAtlas::Mode mode, FontAtlas& atlas) {
+    GlyphRasterizer rasterizer;
+    if (!rasterizer.open(fontPath, mode)) {
+        return false;
+    }
+
+    std::vector<GlyphBitmap> bitmaps(FontAtlas::GLYPH_COUNT);
+    for (int c = 0; c < FontAtlas::GLYPH_COUNT; c++) {
+        if (!rasterizer.rasterize(c, atlas.glyphs[c], bitmaps[c])) {
+            atlas.glyphs[c] = FontGlyph();
+        }
+    }
+
+    atlas.kerning.clear();
+    for (int left = 0; left < FontAtlas::GLYPH_COUNT; left++) {
+        if (!atlas.glyphs[left].Present) continue;
+        for (int right = 0; right < FontAtlas::GLYPH_COUNT; right++) {
+            if (!atlas.glyphs[right].Present) continue;
+            int32_t x = rasterizer.kerning(left, right);
+            if (x != 0) {
+                atlas.kerning.push_back({static_cast<uint16_t>(left), static_cast<uint16_t>(right), x});
+            }
+        }
+    }
+
+    // Tallest first packs the shelves tightest
+    int order[FontAtlas::GLYPH_COUNT];
+    for (int c = 0; c < FontAtlas::GLYPH_COUNT; c++) order[c] = c;
+    std::stable_sort(order, order + FontAtlas::GLYPH_COUNT, [&](int a, int b) {
+        return bitmaps[a].rows > bitmaps[b].rows;
+    });
+
+    const int padding = 1;
+    const int atlasWidth = 512;
+
+    ShelfPacker packer;
+    packer.reset(atlasWidth, 1 << 14);
+
+    for (int c : order) {
+        const GlyphBitmap& bitmap = bitmaps[c];
+        FontGlyph& glyph = atlas.glyphs[c];
+        if (!glyph.Present || bitmap.width == 0 || bitmap.rows == 0) continue;
+
+        int x, y;
+        if (packer.pack(bitmap.width + padding * 2, bitmap.rows + padding * 2, x, y) < 0) {
+            return false;
+        }
+        glyph.TexCoords[0] = glm::vec2(x + padding, y + padding);
+        glyph.TexCoords[1] = glm::vec2(x + padding + bitmap.width, y + padding + bitmap.rows);
+    }
+
+    atlas.mode = rasterizer.getMode();
+    atlas.width = atlasWidth;
+    atlas.height = std::max(packer.getBottom(), 1);
+    atlas.pixels.assign(static_cast<size_t>(atlas.width) * atlas.height, 0);
+
+    for (int c = 0; c < FontAtlas::GLYPH_COUNT; c++) {
+        const GlyphBitmap& bitmap = bitmaps[c];
+        const FontGlyph& glyph = atlas.glyphs[c];
+        if (!glyph.Present) continue;
+
+        int x = static_cast<int>(glyph.TexCoords[0].x);
+        int y = static_cast<int>(glyph.TexCoords[0].y);
+        for (int row = 0; row < bitmap.rows; row++) {
+            std::copy(bitmap.pixels.begin() + row * bitmap.width,
+                      bitmap.pixels.begin() + (row + 1) * bitmap.width,
+                      atlas.pixels.begin() + (y + row) * atlas.width + x);
+        }
+    }
+
+    return true;
+}
+
+#endif
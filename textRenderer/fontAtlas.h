@@ -0,0 +1,123 @@
+// FontAtlas.h
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "shelfPacker/shelfPacker.h"
+
+#ifndef TEXT_RENDERER_NO_FREETYPE
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_CACHE_H
+#endif
+
+// One glyph. Size, Bearing and Advance drive layout and are measured at
+// FontAtlas::PIXEL_SIZE in both modes. QuadOffset/QuadSize place the atlas
+// cell, which for SDF glyphs is rendered smaller and carries the spread border.
+// The struct is stored as-is in .font files, keep it free of padding.
+struct FontGlyph {
+    glm::vec2 TexCoords[2]; // atlas texels, top-left and bottom-right
+    glm::ivec2 Size;
+    glm::ivec2 Bearing;
+    uint32_t Advance;       // 26.6 fixed point
+    glm::vec2 QuadOffset;
+    glm::vec2 QuadSize;
+    uint32_t Present;       // 0 when the font has no glyph for this code
+};
+
+// Horizontal adjustment between two codepoints, 26.6 at FontAtlas::PIXEL_SIZE.
+// Stored as-is in .font files.
+struct KerningPair {
+    uint16_t left, right;
+    int32_t x;
+};
+
+// CPU side of a baked glyph atlas: metrics and kerning pairs for the first
+// 128 codepoints plus the R8 texture they index. Baked from a TTF with FreeType, or loaded from a
+// .font blob written by tools/fontBake so the runtime can ship without it.
+struct FontAtlas {
+    static const int GLYPH_COUNT = 128;
+    static const int PIXEL_SIZE = 48;
+
+    enum Mode {
+        ATLAS_BITMAP,   // coverage rasterized at PIXEL_SIZE
+        ATLAS_SDF       // signed distance field, crisp at any scale
+    };
+
+    Mode mode = ATLAS_BITMAP;
+    int width = 0, height = 0;
+    FontGlyph glyphs[GLYPH_COUNT] = {};
+    std::vector<KerningPair> kerning;   // sorted by (left, right)
+    std::vector<uint8_t> pixels;   // width * height, R8
+};
+
+// Atlas bitmap of one glyph plus its placement relative to the pen
+struct GlyphBitmap {
+    int width = 0, rows = 0;
+    int left = 0, top = 0;
+    std::vector<uint8_t> pixels;   // width * rows, tightly packed
+};
+
+// Loads a .font blob. Returns false without logging when the file is not
+// one, so callers can fall back to baking a TTF.
+bool loadFontAtlas(const char* path, FontAtlas& atlas);
+
+// Writes a .font blob, the pixels optionally PackBits compressed
+bool saveFontAtlas(const char* path, const FontAtlas& atlas, bool compress);
+
+// Build with -DTEXT_RENDERER_NO_FREETYPE to drop FreeType; only .font blobs
+// load then
+#ifndef TEXT_RENDERER_NO_FREETYPE
+
+// Rasterizes single codepoints of one font through FreeType's cache
+// subsystem (ftcache), which keeps the face, charmap lookups and glyph
+// outlines around between calls.
+class GlyphRasterizer {
+public:
+    GlyphRasterizer() = default;
+    GlyphRasterizer(const GlyphRasterizer&) = delete;
+    GlyphRasterizer& operator=(const GlyphRasterizer&) = delete;
+    ~GlyphRasterizer();
+
+    // Falls back to ATLAS_BITMAP when FreeType cannot render SDF glyphs,
+    // check getMode()
+    bool open(const char* fontPath, FontAtlas::Mode mode);
+    void close();
+    bool isOpen() const { return manager != nullptr; }
+    FontAtlas::Mode getMode() const { return mode; }
+
+    // False when the font has no glyph for the codepoint. glyph.TexCoords
+    // are left to the caller, which decides where the bitmap goes.
+    bool rasterize(uint32_t codepoint, FontGlyph& glyph, GlyphBitmap& bitmap);
+
+    // Pen adjustment between two codepoints, 26.6 at FontAtlas::PIXEL_SIZE.
+    // From the 'kern' table, or the GPOS pair adjustments of the 'kern'
+    // feature most current fonts only have.
+    int32_t kerning(uint32_t left, uint32_t right);
+
+private:
+    struct KernSubtable {
+        uint16_t lookup;    // pairs apply once per lookup
+        uint32_t offset;    // PairPos subtable in gpos
+    };
+
+    static FT_Error requestFace(FTC_FaceID faceId, FT_Library library, FT_Pointer data, FT_Face* face);
+    void loadKerning(FT_Face face);
+
+    FT_Library library = nullptr;
+    FTC_Manager manager = nullptr;
+    FTC_CMapCache cmapCache = nullptr;
+    FTC_ImageCache imageCache = nullptr;
+    std::string path;
+    FontAtlas::Mode mode = FontAtlas::ATLAS_BITMAP;
+
+    bool hasKernTable = false;
+    FT_UShort unitsPerEm = 0;
+    std::vector<uint8_t> gpos;
+    std::vector<KernSubtable> kernSubtables;
+};
+
+// Bakes the first GLYPH_COUNT codepoints, shelf packed, with their kerning
+bool bakeFontAtlas(const char* fontPath, FontAtlas::Mode mode, FontAtlas& atlas);
+#endif
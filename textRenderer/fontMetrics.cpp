@@ -0,0 +1,157 @@
+// FontMetrics.cpp
+#include "fontMetrics.h"
+#include "utf8.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FONT_METRICS_SSE2 1
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define FONT_METRICS_WASM_SIMD 1
+#endif
+
+bool FontMetrics::load(const char* fontPath) {
+    FontAtlas atlas;
+    if (!loadFontAtlas(fontPath, atlas)) {
+        loaded = false;
+        return false;
+    }
+    init(atlas);
+    return true;
+}
+
+void FontMetrics::init(const FontAtlas& atlas) {
+    for (int c = 0; c < N; c++) {
+        const FontGlyph& glyph = atlas.glyphs[c];
+        present[c] = glyph.Present != 0;
+        advance[c] = static_cast<float>(glyph.Advance >> 6);
+        height[c] = static_cast<float>(glyph.Size.y);
+        ascent[c] = static_cast<float>(glyph.Bearing.y);
+    }
+
+    std::fill(kerning, kerning + N * N, 0);
+    for (const KerningPair& pair : atlas.kerning) {
+        if (pair.left < N && pair.right < N) {
+            kerning[pair.left * N + pair.right] = static_cast<int16_t>(pair.x);
+        }
+    }
+    loaded = true;
+}
+
+int FontMetrics::glyphIndex(uint32_t codepoint) const {
+    if (codepoint < N && present[codepoint]) return static_cast<int>(codepoint);
+    // The baked set has no U+FFFD, missing printable codepoints show '?'
+    return codepoint >= 0x20 && present['?'] ? '?' : -1;
+}
+
+// Walks the string the way TextRenderer lays it out, so widths match it
+FontMetrics::Metrics FontMetrics::measure(std::string_view text, float scale) const {
+    Metrics metrics = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    float x = 0.0f;
+    uint32_t previous = 0;
+    const char* end = text.data() + text.size();
+    for (const char* p = text.data(); p < end;) {
+        uint32_t codepoint = decodeUtf8(p, end);
+        int glyph = glyphIndex(codepoint);
+        if (glyph < 0) {
+            previous = 0;
+            continue;
+        }
+
+        if (previous && previous < N && codepoint < N) {
+            x += kerning[previous * N + codepoint] / 64.0f * scale;
+        }
+        previous = codepoint;
+
+        float glyphHeight = height[glyph] * scale;
+        float glyphAscent = ascent[glyph] * scale;
+        metrics.height = std::max(metrics.height, glyphHeight);
+        metrics.ascent = std::max(metrics.ascent, glyphAscent);
+        metrics.descent = std::max(metrics.descent, glyphHeight - glyphAscent);
+
+        x += advance[glyph] * scale;
+    }
+
+    metrics.width = x;
+    return metrics;
+}
+
+void FontMetrics::measure(const std::string_view* texts, size_t count, float scale, Metrics* out) const {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = measure(texts[i], scale);
+    }
+}
+
+// In place inclusive prefix sum, four lanes at a time: each vector is
+// scanned with two shifted adds, then offset by the last lane of the
+// previous one
+static void prefixSum(float* values, size_t count) {
+    size_t i = 0;
+    float carry = 0.0f;
+
+#if FONT_METRICS_SSE2
+    __m128 running = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_loadu_ps(values + i);
+        v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+        v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)));
+        v = _mm_add_ps(v, running);
+        _mm_storeu_ps(values + i, v);
+        running = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    carry = _mm_cvtss_f32(running);
+#elif FONT_METRICS_WASM_SIMD
+    v128_t zero = wasm_f32x4_splat(0.0f);
+    v128_t running = zero;
+    for (; i + 4 <= count; i += 4) {
+        v128_t v = wasm_v128_load(values + i);
+        v = wasm_f32x4_add(v, wasm_i32x4_shuffle(zero, v, 0, 4, 5, 6));
+        v = wasm_f32x4_add(v, wasm_i32x4_shuffle(zero, v, 0, 1, 4, 5));
+        v = wasm_f32x4_add(v, running);
+        wasm_v128_store(values + i, v);
+        running = wasm_i32x4_shuffle(v, v, 3, 3, 3, 3);
+    }
+    carry = wasm_f32x4_extract_lane(running, 0);
+#endif
+
+    for (; i < count; i++) {
+        carry += values[i];
+        values[i] = carry;
+    }
+}
+
+size_t FontMetrics::caretPositions(std::string_view text, float x, float scale, float* out, size_t capacity) const {
+    // Step into each stop: the previous glyph's advance plus the kerning
+    // between the two. The first step is the start x.
+    size_t needed = 0;
+    float step = x;
+    uint32_t previous = 0;
+    const char* end = text.data() + text.size();
+    for (const char* p = text.data(); p < end;) {
+        uint32_t codepoint = decodeUtf8(p, end);
+        int glyph = glyphIndex(codepoint);
+        if (glyph >= 0 && previous && previous < N && codepoint < N) {
+            step += kerning[previous * N + codepoint] / 64.0f * scale;
+        }
+        previous = glyph >= 0 ? codepoint : 0;
+
+        if (needed < capacity) out[needed] = step;
+        needed++;
+        step = glyph >= 0 ? advance[glyph] * scale : 0.0f;
+    }
+    if (needed < capacity) out[needed] = step;
+    needed++;
+
+    prefixSum(out, std::min(needed, capacity));
+    return needed;
+}
+
+size_t FontMetrics::hitTest(const float* positions, size_t count, float x) {
+    if (count == 0) return 0;
+    size_t after = static_cast<size_t>(std::lower_bound(positions, positions + count, x) - positions);
+    if (after == 0) return 0;
+    if (after == count) return count - 1;
+    return x - positions[after - 1] <= positions[after] - x ? after - 1 : after;
+}
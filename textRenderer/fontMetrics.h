@@ -0,0 +1,47 @@
+// FontMetrics.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "fontAtlas.h"
+
+// Text measurement from a baked font, no GL context needed. Results match
+// what a TextRenderer showing the same .font draws when it has no dynamic
+// font: codepoints outside the baked set measure as '?', control codes as
+// nothing. Const after load, so worker threads can share one.
+class FontMetrics {
+public:
+    // Same values TextRenderer::getStringMetrics reports
+    struct Metrics {
+        float width, height, ascent, descent;
+    };
+
+    bool load(const char* fontPath);   // .font blob
+    void init(const FontAtlas& atlas);
+    bool isLoaded() const { return loaded; }
+
+    Metrics measure(std::string_view text, float scale) const;
+    void measure(const std::string_view* texts, size_t count, float scale, Metrics* out) const;
+
+    // Caret stops: the pen x before each codepoint, then the end of the
+    // string, so codepoints + 1 values. Writes at most capacity and returns
+    // how many the full string needs. Summed as a SIMD prefix sum, so the
+    // last bits can differ from the renderer's running sum.
+    size_t caretPositions(std::string_view text, float x, float scale, float* out, size_t capacity) const;
+
+    // Index of the caret stop nearest to x in sorted positions
+    static size_t hitTest(const float* positions, size_t count, float x);
+
+private:
+    static const int N = FontAtlas::GLYPH_COUNT;
+
+    // Glyph drawn for a codepoint, -1 for none
+    int glyphIndex(uint32_t codepoint) const;
+
+    bool loaded = false;
+    float advance[N] = {};      // whole pixels at PIXEL_SIZE, as the renderer rounds
+    float height[N] = {};
+    float ascent[N] = {};
+    bool present[N] = {};
+    int16_t kerning[N * N] = {};    // 26.6, left * N + right
+};
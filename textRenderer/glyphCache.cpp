@@ -0,0 +1,347 @@
+// GlyphCache.cpp
+#include "glyphCache.h"
+#include "glState/glState.h"
+#include "logger/logger.h"
+#include <algorithm>
+#include <cstring>
+
+bool GlyphCache::init(const FontAtlas& baked) {
+    cleanup();
+
+    mode = baked.mode;
+    height = MIN_HEIGHT;
+    pixels.assign(static_cast<size_t>(WIDTH) * height, 0);
+    packer.reset(WIDTH, height);
+
+    // Tallest first packs the shelves tightest
+    int order[FontAtlas::GLYPH_COUNT];
+    for (int c = 0; c < FontAtlas::GLYPH_COUNT; c++) order[c] = c;
+    std::stable_sort(order, order + FontAtlas::GLYPH_COUNT, [&](int a, int b) {
+        return baked.glyphs[a].TexCoords[1].y - baked.glyphs[a].TexCoords[0].y >
+               baked.glyphs[b].TexCoords[1].y - baked.glyphs[b].TexCoords[0].y;
+    });
+
+    GlyphBitmap bitmap;
+    for (int c : order) {
+        FontGlyph glyph = baked.glyphs[c];
+        if (!glyph.Present) continue;
+
+        // Cut the glyph out of the baked atlas, placement comes from the quad
+        int x0 = static_cast<int>(glyph.TexCoords[0].x);
+        int y0 = static_cast<int>(glyph.TexCoords[0].y);
+        bitmap.width = static_cast<int>(glyph.TexCoords[1].x) - x0;
+        bitmap.rows = static_cast<int>(glyph.TexCoords[1].y) - y0;
+        bitmap.pixels.resize(static_cast<size_t>(bitmap.width) * bitmap.rows);
+        for (int row = 0; row < bitmap.rows; row++) {
+            memcpy(bitmap.pixels.data() + row * bitmap.width,
+                   baked.pixels.data() + (y0 + row) * baked.width + x0, bitmap.width);
+        }
+
+        if (!place(static_cast<uint32_t>(c), glyph, bitmap, true)) {
+            LOG_ERROR(LOG_RENDER, "GlyphCache: baked glyphs do not fit a %dx%d atlas\n", WIDTH, MAX_HEIGHT);
+            return false;
+        }
+        hasBaked = true;
+    }
+
+    for (const KerningPair& pair : baked.kerning) {
+        bakedKerning[static_cast<uint32_t>(pair.left) << 16 | pair.right] = pair.x;
+    }
+
+    glGenTextures(1, &texture);
+    glState.bindTexture(0, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    textureHeight = 0;
+
+    // Float textures are fetched, never filtered
+    glGenTextures(1, &metricsTexture);
+    glState.bindTexture(0, metricsTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    metricsRows = 0;
+    upload();
+
+    return true;
+}
+
+void GlyphCache::cleanup() {
+    if (texture) {
+        glState.deleteTexture(texture);
+        texture = 0;
+    }
+    if (metricsTexture) {
+        glState.deleteTexture(metricsTexture);
+        metricsTexture = 0;
+    }
+    metricsRows = 0;
+    metricsDirtyMin = metricsDirtyMax = 0;
+    metrics.clear();
+    textureHeight = 0;
+    height = 0;
+    dirtyMin = dirtyMax = 0;
+    pixels.clear();
+    shelves.clear();
+    std::fill(dense.begin(), dense.end(), UNKNOWN);
+    sparse.clear();
+    slots.clear();
+    freeSlots.clear();
+    hasBaked = false;
+    bakedKerning.clear();
+    evictions = 0;
+    generation++;
+}
+
+bool GlyphCache::setDynamicFont(const char* fontPath) {
+#ifdef TEXT_RENDERER_NO_FREETYPE
+    LOG_WARN(LOG_RENDER, "GlyphCache: built without FreeType, %s not loaded\n", fontPath);
+    return false;
+#else
+    if (!rasterizer.open(fontPath, mode)) {
+        return false;
+    }
+
+    if (rasterizer.getMode() != mode) {
+        if (slots.size() > freeSlots.size()) {
+            LOG_ERROR(LOG_RENDER, "GlyphCache: %s cannot be rasterized in the baked atlas mode\n", fontPath);
+            rasterizer.close();
+            return false;
+        }
+        mode = rasterizer.getMode();
+    }
+
+    // Codepoints that were missing before may exist in this font
+    generation++;
+    std::replace(dense.begin(), dense.end(), MISSING, UNKNOWN);
+    for (auto it = sparse.begin(); it != sparse.end();) {
+        it = it->second == MISSING ? sparse.erase(it) : std::next(it);
+    }
+
+    // Pin the replacement character, missing glyphs fall back to it
+    FontGlyph glyph;
+    if (lookup(0xFFFD) < 0 && rasterizer.rasterize(0xFFFD, glyph, scratch)) {
+        place(0xFFFD, glyph, scratch, true);
+    }
+    return true;
+#endif
+}
+
+int32_t GlyphCache::lookup(uint32_t codepoint) const {
+    if (codepoint < DENSE_COUNT) return dense[codepoint];
+    auto it = sparse.find(codepoint);
+    return it == sparse.end() ? UNKNOWN : it->second;
+}
+
+void GlyphCache::assign(uint32_t codepoint, int32_t slot) {
+    if (codepoint < DENSE_COUNT) {
+        dense[codepoint] = slot;
+    } else if (slot == UNKNOWN) {
+        sparse.erase(codepoint);
+    } else {
+        sparse[codepoint] = slot;
+    }
+}
+
+int32_t GlyphCache::kerning(uint32_t left, uint32_t right) {
+    if (hasBaked && left < FontAtlas::GLYPH_COUNT && right < FontAtlas::GLYPH_COUNT) {
+        auto it = bakedKerning.find(left << 16 | right);
+        return it == bakedKerning.end() ? 0 : it->second;
+    }
+#ifndef TEXT_RENDERER_NO_FREETYPE
+    if (rasterizer.isOpen()) return rasterizer.kerning(left, right);
+#endif
+    return 0;
+}
+
+const FontGlyph* GlyphCache::findSlow(uint32_t codepoint) {
+    int32_t slot = lookup(codepoint);
+    if (slot >= 0) {
+        const Entry& entry = slots[slot];
+        if (entry.shelf >= 0) shelves[entry.shelf].lastUsed = tick;
+        return &entry.glyph;
+    }
+    if (slot == MISSING) return nullptr;
+
+#ifndef TEXT_RENDERER_NO_FREETYPE
+    // Once the atlas is full of this batch's glyphs, skip rasterizing
+    // anything else until the next one
+    if (fullTick == tick) return nullptr;
+
+    FontGlyph glyph;
+    if (rasterizer.isOpen() && rasterizer.rasterize(codepoint, glyph, scratch)) {
+        // A full atlas is not cached as missing, the glyph may fit next batch
+        if (!place(codepoint, glyph, scratch, false)) {
+            fullTick = tick;
+            return nullptr;
+        }
+        return &slots[lookup(codepoint)].glyph;
+    }
+#endif
+
+    assign(codepoint, MISSING);
+    return nullptr;
+}
+
+bool GlyphCache::place(uint32_t codepoint, FontGlyph& glyph, const GlyphBitmap& bitmap, bool pinned) {
+    int shelf = -1;
+
+    if (bitmap.width > 0 && bitmap.rows > 0) {
+        shelf = pack(glyph, bitmap, pinned);
+        if (shelf < 0) return false;
+
+        ShelfInfo& info = shelves[shelf];
+        info.codepoints.push_back(codepoint);
+        info.pinned = info.pinned || pinned;
+        info.lastUsed = tick;
+    }
+
+    int32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<int32_t>(slots.size());
+        slots.emplace_back();
+    }
+    slots[slot] = {glyph, codepoint, shelf};
+    assign(codepoint, slot);
+    writeMetrics(slot);
+    return true;
+}
+
+void GlyphCache::writeMetrics(int32_t slot) {
+    size_t needed = static_cast<size_t>(slot / METRICS_PER_ROW + 1) * METRICS_PER_ROW * 2;
+    if (metrics.size() < needed) metrics.resize(needed, glm::vec4(0.0f));
+
+    const FontGlyph& glyph = slots[slot].glyph;
+    metrics[slot * 2] = glm::vec4(glyph.QuadOffset, glyph.QuadSize);
+    metrics[slot * 2 + 1] = glm::vec4(glyph.TexCoords[0], glyph.TexCoords[1]);
+
+    if (metricsDirtyMax <= metricsDirtyMin) {
+        metricsDirtyMin = slot;
+        metricsDirtyMax = slot + 1;
+    } else {
+        metricsDirtyMin = std::min(metricsDirtyMin, slot);
+        metricsDirtyMax = std::max(metricsDirtyMax, slot + 1);
+    }
+}
+
+int GlyphCache::pack(FontGlyph& glyph, const GlyphBitmap& bitmap, bool pinned) {
+    int w = bitmap.width + PADDING * 2;
+    int h = bitmap.rows + PADDING * 2;
+    int x, y;
+    int shelf;
+    while ((shelf = packer.pack(w, h, x, y)) < 0) {
+        if (!grow() && (pinned || !evictFor(w, h))) {
+            return -1;
+        }
+    }
+
+    if (shelf >= (int)shelves.size()) shelves.resize(shelf + 1);
+
+    x += PADDING;
+    y += PADDING;
+    for (int row = 0; row < bitmap.rows; row++) {
+        memcpy(pixels.data() + (y + row) * WIDTH + x,
+               bitmap.pixels.data() + row * bitmap.width, bitmap.width);
+    }
+    markDirty(y, y + bitmap.rows);
+
+    glyph.TexCoords[0] = glm::vec2(x, y);
+    glyph.TexCoords[1] = glm::vec2(x + bitmap.width, y + bitmap.rows);
+    return shelf;
+}
+
+bool GlyphCache::grow() {
+    if (height >= MAX_HEIGHT) return false;
+
+    // Rows keep their offsets, so every placed glyph stays valid
+    height *= 2;
+    pixels.resize(static_cast<size_t>(WIDTH) * height, 0);
+    packer.setHeight(height);
+
+    LOG_DEBUG(LOG_RENDER, "GlyphCache: atlas grown to %dx%d\n", WIDTH, height);
+    return true;
+}
+
+bool GlyphCache::evictFor(int w, int h) {
+    if (w > WIDTH) return false;
+
+    const std::vector<ShelfPacker::Shelf>& packed = packer.getShelves();
+
+    // Least recently used shelf tall enough, never one touched this batch
+    int victim = -1;
+    for (int i = 0; i < (int)shelves.size(); i++) {
+        const ShelfInfo& info = shelves[i];
+        if (info.pinned || info.lastUsed == tick || packed[i].height < h) continue;
+        if (victim < 0 || info.lastUsed < shelves[victim].lastUsed) victim = i;
+    }
+    if (victim < 0) return false;
+
+    ShelfInfo& info = shelves[victim];
+    for (uint32_t codepoint : info.codepoints) {
+        freeSlots.push_back(lookup(codepoint));
+        assign(codepoint, UNKNOWN);
+    }
+    info.codepoints.clear();
+    packer.clearShelf(victim);
+
+    // Clear the rows so stale texels cannot bleed into new neighbours
+    const ShelfPacker::Shelf& shelf = packed[victim];
+    memset(pixels.data() + shelf.y * WIDTH, 0, static_cast<size_t>(shelf.height) * WIDTH);
+    markDirty(shelf.y, shelf.y + shelf.height);
+
+    evictions++;
+    generation++;
+    return true;
+}
+
+void GlyphCache::markDirty(int y0, int y1) {
+    if (dirtyMax <= dirtyMin) {
+        dirtyMin = y0;
+        dirtyMax = y1;
+    } else {
+        dirtyMin = std::min(dirtyMin, y0);
+        dirtyMax = std::max(dirtyMax, y1);
+    }
+}
+
+void GlyphCache::upload() {
+    uploadMetrics();
+    if (!texture || (textureHeight == height && dirtyMax <= dirtyMin)) return;
+
+    glState.bindTexture(0, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if (textureHeight != height) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, WIDTH, height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+        textureHeight = height;
+    } else if (dirtyMax > dirtyMin) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, dirtyMin, WIDTH, dirtyMax - dirtyMin,
+                        GL_RED, GL_UNSIGNED_BYTE, pixels.data() + static_cast<size_t>(dirtyMin) * WIDTH);
+    }
+
+    dirtyMin = dirtyMax = 0;
+}
+
+void GlyphCache::uploadMetrics() {
+    int rows = std::max(1, static_cast<int>(metrics.size() / (METRICS_PER_ROW * 2)));
+    if (!metricsTexture || (metricsRows == rows && metricsDirtyMax <= metricsDirtyMin)) return;
+
+    if (metrics.empty()) metrics.resize(METRICS_PER_ROW * 2, glm::vec4(0.0f));
+    glState.bindTexture(0, metricsTexture);
+
+    if (metricsRows != rows) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, METRICS_PER_ROW * 2, rows, 0, GL_RGBA, GL_FLOAT, metrics.data());
+        metricsRows = rows;
+    } else {
+        int row0 = metricsDirtyMin / METRICS_PER_ROW;
+        int row1 = (metricsDirtyMax - 1) / METRICS_PER_ROW + 1;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row0, METRICS_PER_ROW * 2, row1 - row0, GL_RGBA, GL_FLOAT,
+                        metrics.data() + static_cast<size_t>(row0) * METRICS_PER_ROW * 2);
+    }
+
+    metricsDirtyMin = metricsDirtyMax = 0;
+}
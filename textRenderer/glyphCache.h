@@ -0,0 +1,147 @@
+// GlyphCache.h
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <GLES3/gl3.h>
+#include "fontAtlas.h"
+
+// Glyph atlas texture filled on demand. Glyphs of a baked FontAtlas are
+// pinned; any other codepoint is rasterized from the dynamic font (FreeType
+// builds only) the first time it is looked up, shelf packed, and uploaded
+// with glTexSubImage2D on the next upload(). The atlas doubles in height up
+// to MAX_HEIGHT, after that the least recently used shelf is evicted.
+// Every resident glyph has a slot id; a second, RGBA32F texture holds the
+// quad and texel rect of each slot so shaders can place glyphs by id.
+class GlyphCache {
+public:
+    static const int WIDTH = 1024;
+    static const int MIN_HEIGHT = 256;
+    static const int MAX_HEIGHT = 2048;   // ES3 guarantees 2048 texture sizes
+
+    // Metrics texture: slot id s is texels (2s, 2s+1) of row s / METRICS_PER_ROW,
+    // (QuadOffset, QuadSize) then (TexCoords[0], TexCoords[1])
+    static const int METRICS_PER_ROW = 256;
+
+    bool init(const FontAtlas& baked);
+    void cleanup();
+
+    // Rasterizes glyphs missing from the baked atlas from this TTF. Only a
+    // cache without glyphs can switch mode if FreeType lacks SDF support.
+    bool setDynamicFont(const char* fontPath);
+
+    // nullptr when the font has no glyph for the codepoint or the atlas is
+    // full of glyphs used since beginBatch. TexCoords are texels. The pointer
+    // is only good until the next find.
+    const FontGlyph* find(uint32_t codepoint) {
+        int32_t slot = codepoint < DENSE_COUNT ? dense[codepoint] : UNKNOWN;
+        if (slot >= 0) {
+            const Entry& entry = slots[slot];
+            if (entry.shelf >= 0) shelves[entry.shelf].lastUsed = tick;
+            return &entry.glyph;
+        }
+        return slot == MISSING ? nullptr : findSlow(codepoint);
+    }
+
+    // Pen adjustment between two codepoints, 26.6 at FontAtlas::PIXEL_SIZE.
+    // Baked pairs cover the baked codepoints, the dynamic font the rest.
+    int32_t kerning(uint32_t left, uint32_t right);
+
+    // Glyphs found after this stay resident until the next call
+    void beginBatch() { tick++; }
+
+    // Slot id of a resident glyph, -1 for unknown ones
+    int32_t getSlot(uint32_t codepoint) const {
+        int32_t slot = lookup(codepoint);
+        return slot >= 0 ? slot : -1;
+    }
+
+    // Shelf holding a resident glyph, -1 for blank or unknown ones. Touching
+    // a shelf keeps it resident for the batch like a find would.
+    int getShelf(uint32_t codepoint) const {
+        int32_t slot = lookup(codepoint);
+        return slot >= 0 ? slots[slot].shelf : -1;
+    }
+    void touch(int shelf) { shelves[shelf].lastUsed = tick; }
+
+    // Changes whenever glyphs already handed out may have moved: on init,
+    // eviction and a new dynamic font. Anything holding TexCoords across
+    // batches compares it.
+    uint32_t getGeneration() const { return generation; }
+
+    // Sends rows written since the last upload, or the whole atlas after it
+    // grew, and the same for the metrics texture. Uses texture unit 0.
+    void upload();
+
+    GLuint getTexture() const { return texture; }
+    GLuint getMetricsTexture() const { return metricsTexture; }
+    FontAtlas::Mode getMode() const { return mode; }
+    int getHeight() const { return height; }
+    int getEvictions() const { return evictions; }
+
+private:
+    static const int PADDING = 1;
+
+    // Codepoints below this index a flat table (Latin, Greek, Cyrillic...),
+    // the rest go through a hash map
+    static const uint32_t DENSE_COUNT = 0x800;
+    static const int32_t UNKNOWN = -1;
+    static const int32_t MISSING = -2;
+
+    struct Entry {
+        FontGlyph glyph;
+        uint32_t codepoint;
+        int shelf;          // -1 for blank glyphs, they take no atlas space
+    };
+
+    struct ShelfInfo {
+        uint32_t lastUsed = 0;
+        bool pinned = false;
+        std::vector<uint32_t> codepoints;
+    };
+
+    const FontGlyph* findSlow(uint32_t codepoint);
+    int32_t lookup(uint32_t codepoint) const;
+    void assign(uint32_t codepoint, int32_t slot);
+    bool place(uint32_t codepoint, FontGlyph& glyph, const GlyphBitmap& bitmap, bool pinned);
+    int pack(FontGlyph& glyph, const GlyphBitmap& bitmap, bool pinned);
+    bool grow();
+    bool evictFor(int w, int h);
+    void markDirty(int y0, int y1);
+    void writeMetrics(int32_t slot);
+    void uploadMetrics();
+
+    FontAtlas::Mode mode = FontAtlas::ATLAS_BITMAP;
+    GLuint texture = 0;
+    int height = 0;
+    int textureHeight = 0;      // height the GL texture was allocated with
+    int dirtyMin = 0, dirtyMax = 0;
+
+    std::vector<uint8_t> pixels;    // WIDTH * height shadow of the texture
+    ShelfPacker packer;
+    std::vector<ShelfInfo> shelves;
+
+    // Slot of every known codepoint, or UNKNOWN / MISSING
+    std::vector<int32_t> dense = std::vector<int32_t>(DENSE_COUNT, UNKNOWN);
+    std::unordered_map<uint32_t, int32_t> sparse;
+    std::vector<Entry> slots;
+    std::vector<int32_t> freeSlots;
+
+    GLuint metricsTexture = 0;
+    int metricsRows = 0;            // rows the GL texture was allocated with
+    int32_t metricsDirtyMin = 0, metricsDirtyMax = 0;   // slots
+    std::vector<glm::vec4> metrics;     // 2 texels per slot, whole rows
+
+    bool hasBaked = false;
+    std::unordered_map<uint32_t, int32_t> bakedKerning;   // left << 16 | right
+
+    uint32_t tick = 1;
+    uint32_t fullTick = 0;      // batch in which the atlas ran out of room
+    uint32_t generation = 1;
+    int evictions = 0;
+
+#ifndef TEXT_RENDERER_NO_FREETYPE
+    GlyphRasterizer rasterizer;
+    GlyphBitmap scratch;
+#endif
+};
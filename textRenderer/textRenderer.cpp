@@ -1,44 +1,87 @@
 // TextRenderer.cpp
-#include "TextRenderer.h"
+#include "textRenderer.h"
+#include "utf8.h"
+#include "glState/glState.h"
+#include "glState/streamBuffer.h"
+#include "logger/logger.h"
 #include <stdexcept>
 #include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-TextRenderer::TextRenderer() : initialized(false), atlasTexture(0), currentZIndex(0),
+TextRenderer::TextRenderer() : initialized(false), currentZIndex(0),
                                screenWidth(800), screenHeight(600) {
+    // Instanced: a 4 vertex strip per glyph, gl_VertexID picks the corner.
+    // glyphMetrics holds two texels per glyph cache slot, quad placement
+    // (offset, size) then the atlas rect in texels.
     vertexShaderSource = R"(#version 300 es
-        layout (location = 0) in vec4 vertex;
+        layout (location = 0) in vec3 pen;      // x, y, scale
+        layout (location = 1) in uint slot;
+        layout (location = 2) in vec4 color;
         out vec2 TexCoords;
+        out vec4 TextColor;
         uniform mat4 projection;
+        uniform sampler2D text;
+        uniform highp sampler2D glyphMetrics;
+
+        const uint METRICS_PER_ROW = 256u;
 
         void main() {
-            gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
-            TexCoords = vertex.zw;
+            ivec2 at = ivec2(int(slot % METRICS_PER_ROW) * 2, int(slot / METRICS_PER_ROW));
+            vec4 quad = texelFetch(glyphMetrics, at, 0);
+            vec4 rect = texelFetch(glyphMetrics, at + ivec2(1, 0), 0);
+
+            vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+            vec2 origin = vec2(quad.x, quad.y - quad.w);
+            gl_Position = projection * vec4(pen.xy + (origin + corner * quad.zw) * pen.z, 0.0, 1.0);
+
+            // Texel coordinates, the glyph cache atlas grows at runtime; the
+            // atlas is stored top row first
+            TexCoords = vec2(mix(rect.x, rect.z, corner.x), mix(rect.w, rect.y, corner.y)) /
+                        vec2(textureSize(text, 0));
+            TextColor = color;
         }
     )";
 
     fragmentShaderSource = R"(#version 300 es
         precision mediump float;
         in vec2 TexCoords;
+        in vec4 TextColor;
         out vec4 FragColor;
         uniform sampler2D text;
-        uniform vec4 textColor;
 
         void main() {
             float alpha = texture(text, TexCoords).r;
-            FragColor = vec4(textColor.rgb, textColor.a * alpha);
+            FragColor = vec4(TextColor.rgb, TextColor.a * alpha);
+        }
+    )";
+
+    // 0.5 is the outline; the smoothstep width follows the on-screen
+    // derivative, so edges stay one pixel wide at every scale
+    sdfFragmentShaderSource = R"(#version 300 es
+        precision mediump float;
+        in vec2 TexCoords;
+        in vec4 TextColor;
+        out vec4 FragColor;
+        uniform sampler2D text;
+
+        void main() {
+            float distance = texture(text, TexCoords).r;
+            float width = max(fwidth(distance), 1e-4);
+            float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+            FragColor = vec4(TextColor.rgb, TextColor.a * alpha);
         }
     )";
 }
 
 TextRenderer::~TextRenderer() {
     if (initialized) {
-        glDeleteTextures(1, &atlasTexture);
-        glDeleteVertexArrays(1, &vao);
-        glDeleteBuffers(1, &vbo);
-        glDeleteBuffers(1, &ibo);
-        glDeleteProgram(shaderProgram);
+        glyphCache.cleanup();
+        glState.deleteVertexArray(vao);
+        glState.deleteBuffer(vbo);
+        glState.deleteProgram(shaderProgram);
     }
 }
 
@@ -57,146 +100,53 @@ GLuint TextRenderer::compileShader(GLenum type, const char* source) {
     return shader;
 }
 
-bool TextRenderer::generateAtlas(FT_Face face) {
-    FT_Set_Pixel_Sizes(face, 0, 48);
-
-    int maxWidth = 0, maxHeight = 0;
-
-    for (unsigned char c = 0; c < 128; c++) {
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-            continue;
-        }
-        maxWidth = std::max(maxWidth, static_cast<int>(face->glyph->bitmap.width));
-        maxHeight = std::max(maxHeight, static_cast<int>(face->glyph->bitmap.rows));
-    }
-
-    const int padding = 1;
-    maxWidth += padding * 2;
-    maxHeight += padding * 2;
-
-    const int charsPerRow = 16;
-    int atlasWidth = maxWidth * charsPerRow;
-    int atlasHeight = maxHeight * ((128 + charsPerRow - 1) / charsPerRow);
-
-    std::vector<unsigned char> atlasBuffer(atlasWidth * atlasHeight, 0);
-
-    int xOffset = 0, yOffset = 0;
-
-    for (unsigned char c = 0; c < 128; c++) {
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-            continue;
-        }
-
-        FT_Bitmap& bitmap = face->glyph->bitmap;
-
-        if (xOffset + maxWidth > atlasWidth) {
-            xOffset = 0;
-            yOffset += maxHeight;
-        }
-
-        int xPos = xOffset + padding;
-        int yPos = yOffset + padding;
-
-        for (unsigned int row = 0; row < bitmap.rows; row++) {
-            for (unsigned int col = 0; col < bitmap.width; col++) {
-                size_t atlasIndex = (yPos + row) * atlasWidth + (xPos + col);
-                if (atlasIndex < atlasBuffer.size()) {
-                    atlasBuffer[atlasIndex] = bitmap.buffer[row * bitmap.width + col];
-                }
-            }
-        }
-
-        float x1 = static_cast<float>(xPos) / static_cast<float>(atlasWidth);
-        float y1 = static_cast<float>(yPos) / static_cast<float>(atlasHeight);
-        float x2 = static_cast<float>(xPos + bitmap.width) / static_cast<float>(atlasWidth);
-        float y2 = static_cast<float>(yPos + bitmap.rows) / static_cast<float>(atlasHeight);
-
-        Character character = {
-            {glm::vec2(x1, y1), glm::vec2(x2, y2)},
-            glm::ivec2(bitmap.width, bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            static_cast<GLuint>(face->glyph->advance.x)
-        };
-
-        characters.insert(std::pair<char, Character>(c, character));
-
-        xOffset += maxWidth;
-    }
-
-    glGenTextures(1, &atlasTexture);
-    glBindTexture(GL_TEXTURE_2D, atlasTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasWidth, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, atlasBuffer.data());
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    return true;
-}
-
-bool TextRenderer::initialize(const char* fontPath, int width, int height) {
+bool TextRenderer::initialize(const char* fontPath, int width, int height, AtlasMode mode) {
     screenWidth = width;
     screenHeight = height;
     currentZIndex = 0;
 
-    FT_Library ft;
-    if (FT_Init_FreeType(&ft)) {
-        return false;
-    }
-
-    FT_Face face;
-    if (FT_New_Face(ft, fontPath, 0, &face)) {
-        FT_Done_FreeType(ft);
-        return false;
-    }
-
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-    if (!generateAtlas(face)) {
-        FT_Done_Face(face);
-        FT_Done_FreeType(ft);
-        return false;
+    FontAtlas atlas;
+    if (loadFontAtlas(fontPath, atlas)) {
+        if (!glyphCache.init(atlas)) {
+            return false;
+        }
+    } else {
+        // A TTF: nothing is baked, every glyph rasterizes on first use
+        atlas.mode = mode;
+        if (!glyphCache.init(atlas) || !glyphCache.setDynamicFont(fontPath)) {
+            LOG_ERROR(LOG_ASSET, "%s is neither a baked font atlas nor a font FreeType can load\n", fontPath);
+            glyphCache.cleanup();
+            return false;
+        }
     }
+    atlasMode = glyphCache.getMode();
+    layoutCache.assign(LAYOUT_CACHE_SIZE, CachedLayout());
 
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+    LOG_INFO(LOG_RENDER, "TextRenderer: %s glyph cache %dx%d\n",
+             atlasMode == FontAtlas::ATLAS_SDF ? "SDF" : "bitmap", GlyphCache::WIDTH, glyphCache.getHeight());
 
-    // Setup VAO/VBO/IBO
+    // Setup VAO/VBO, every attribute advances per instance
     glGenVertexArrays(1, &vao);
     glGenBuffers(1, &vbo);
-    glGenBuffers(1, &ibo);
-
-    glBindVertexArray(vao);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 4 * 4 * 4096, NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
+    glState.bindVertexArray(vao);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-
-    indices.clear();
-    constexpr int MAX_CHARS = 4096;
-    indices.reserve(MAX_CHARS * 6);
-
-    for (int i = 0; i < MAX_CHARS; i++) {
-        int baseVertex = i * 4;
-        indices.push_back(baseVertex + 0);
-        indices.push_back(baseVertex + 1);
-        indices.push_back(baseVertex + 2);
-        indices.push_back(baseVertex + 1);
-        indices.push_back(baseVertex + 3);
-        indices.push_back(baseVertex + 2);
+    glState.bindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, RING_GLYPHS * sizeof(GlyphInstance), NULL, GL_STREAM_DRAW);
+    ringGlyph = 0;
+    for (GLuint attribute = 0; attribute < 3; attribute++) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
     }
+    pointAttributes(0);
 
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    glState.bindBuffer(GL_ARRAY_BUFFER, 0);
+    glState.bindVertexArray(0);
 
     // Compile shaders
     GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER,
+        atlasMode == FontAtlas::ATLAS_SDF ? sdfFragmentShaderSource : fragmentShaderSource);
 
     shaderProgram = glCreateProgram();
     glAttachShader(shaderProgram, vertexShader);
@@ -216,10 +166,38 @@ bool TextRenderer::initialize(const char* fontPath, int width, int height) {
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
 
+    projectionLoc = glState.uniformLocation(shaderProgram, "projection");
+
+    // The atlas always sits on unit 0, the glyph metrics on unit 1
+    glState.useProgram(shaderProgram);
+    glUniform1i(glState.uniformLocation(shaderProgram, "text"), 0);
+    glUniform1i(glState.uniformLocation(shaderProgram, "glyphMetrics"), 1);
+
     initialized = true;
     return true;
 }
 
+bool TextRenderer::setDynamicFont(const char* fontPath) {
+    return glyphCache.setDynamicFont(fontPath);
+}
+
+const FontGlyph* TextRenderer::glyphFor(uint32_t codepoint, uint32_t* found) {
+    const FontGlyph* glyph = glyphCache.find(codepoint);
+
+    // Control codes stay invisible, other missing codepoints draw as U+FFFD,
+    // or '?' when the font has no replacement character either
+    if (!glyph && codepoint >= 0x20) {
+        codepoint = 0xFFFD;
+        glyph = glyphCache.find(codepoint);
+        if (!glyph) {
+            codepoint = '?';
+            glyph = glyphCache.find(codepoint);
+        }
+    }
+    if (found) *found = codepoint;
+    return glyph;
+}
+
 void TextRenderer::setScreenSize(int width, int height) {
     screenWidth = width;
     screenHeight = height;
@@ -232,167 +210,310 @@ void TextRenderer::setupRenderState() {
                                        0.0f, static_cast<float>(screenHeight), 
                                        -1.0f, 1.0f);
 
-    glBindVertexArray(vao);
-    glUseProgram(shaderProgram);
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, atlasTexture);
-    glUniform1i(glGetUniformLocation(shaderProgram, "text"), 0);
+    glState.setBlend(true);
+    glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glState.bindVertexArray(vao);
+    glState.useProgram(shaderProgram);
+    glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    glState.bindTexture(0, glyphCache.getTexture());
+    glState.bindTexture(1, glyphCache.getMetricsTexture());
 }
 
-void TextRenderer::cleanupRenderState() {
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glUseProgram(0);
+// Points the instance attributes at firstInstance of the bound VBO
+void TextRenderer::pointAttributes(size_t firstInstance) {
+    size_t base = firstInstance * sizeof(GlyphInstance);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), (void*)(base + offsetof(GlyphInstance, x)));
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_SHORT, sizeof(GlyphInstance), (void*)(base + offsetof(GlyphInstance, slot)));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(GlyphInstance), (void*)(base + offsetof(GlyphInstance, r)));
 }
 
-void TextRenderer::draw(const std::string& text, float x, float y, float scale, glm::vec4 color) {
-    textQueue.push_back({text, x, y, scale, color, false, currentZIndex++});
+// Steady state this does not allocate: the queue and arena keep their
+// capacity across flushes
+void TextRenderer::enqueue(std::string_view text, float x, float y, float scale,
+                           glm::vec4 color, bool centered, int zIndex) {
+    uint32_t offset = static_cast<uint32_t>(textArena.size());
+    textArena.insert(textArena.end(), text.begin(), text.end());
+    textQueue.push_back({nullptr, offset, static_cast<uint32_t>(text.size()), x, y, scale, color,
+                         centered, zIndex, static_cast<uint32_t>(textQueue.size())});
+    if (renderQueue) pushToQueue(zIndex);
 }
 
-void TextRenderer::draw(const std::string& text, float x, float y, float scale, glm::vec4 color, int zIndex) {
-    textQueue.push_back({text, x, y, scale, color, false, zIndex});
+void TextRenderer::enqueue(TextLayout& layout, float x, float y, glm::vec4 color, bool centered, int zIndex) {
+    textQueue.push_back({&layout, 0, 0, x, y, layout.scale, color,
+                         centered, zIndex, static_cast<uint32_t>(textQueue.size())});
+    if (renderQueue) pushToQueue(zIndex);
 }
 
-void TextRenderer::drawCentered(const std::string& text, float x, float y, float scale, glm::vec4 color) {
-    textQueue.push_back({text, x, y, scale, color, true, currentZIndex++});
+// zIndex is the key's depth, flipping the sign bit keeps negative ones first
+void TextRenderer::pushToQueue(int zIndex) {
+    renderQueue->push(shaderId, glyphCache.getTexture(), static_cast<uint32_t>(zIndex) ^ 0x80000000u,
+                      static_cast<uint32_t>(textQueue.size() - 1));
 }
 
-void TextRenderer::drawCentered(const std::string& text, float x, float y, float scale, glm::vec4 color, int zIndex) {
-    textQueue.push_back({text, x, y, scale, color, true, zIndex});
+void TextRenderer::draw(std::string_view text, float x, float y, float scale, glm::vec4 color) {
+    enqueue(text, x, y, scale, color, false, currentZIndex++);
 }
 
-void TextRenderer::flush() {
-    if (!initialized || textQueue.empty()) return;
+void TextRenderer::draw(std::string_view text, float x, float y, float scale, glm::vec4 color, int zIndex) {
+    enqueue(text, x, y, scale, color, false, zIndex);
+}
 
-    std::sort(textQueue.begin(), textQueue.end(),
-              [](const QueuedText& a, const QueuedText& b) {
-                  return a.zIndex < b.zIndex;
-              });
+void TextRenderer::drawCentered(std::string_view text, float x, float y, float scale, glm::vec4 color) {
+    enqueue(text, x, y, scale, color, true, currentZIndex++);
+}
 
-    setupRenderState();
+void TextRenderer::drawCentered(std::string_view text, float x, float y, float scale, glm::vec4 color, int zIndex) {
+    enqueue(text, x, y, scale, color, true, zIndex);
+}
+
+TextLayout TextRenderer::createLayout(std::string_view text, float scale) {
+    TextLayout layout;
+    layout.text.assign(text.data(), text.size());
+    layout.scale = scale;
+    if (initialized) buildLayout(layout);
+    return layout;
+}
 
-    struct Vec4Comparator {
-        bool operator()(const glm::vec4& a, const glm::vec4& b) const {
-            if (a.x != b.x) return a.x < b.x;
-            if (a.y != b.y) return a.y < b.y;
-            if (a.z != b.z) return a.z < b.z;
-            return a.w < b.w;
+// Lays the text out at pen (0, 0), kerned, with its metrics, remembering
+// which shelves it samples so drawing can keep them resident
+void TextRenderer::buildLayout(TextLayout& layout) {
+    layout.width = layout.maxHeight = layout.maxAscent = layout.maxDescent = 0.0f;
+    layout.glyphs.clear();
+    layout.shelves.clear();
+    layout.generation = glyphCache.getGeneration();
+
+    float scale = layout.scale;
+    float x = 0.0f;
+    uint32_t previous = 0;
+    const char* end = layout.text.data() + layout.text.size();
+    for (const char* p = layout.text.data(); p < end;) {
+        uint32_t codepoint = decodeUtf8(p, end);
+        uint32_t found;
+        const FontGlyph* glyph = glyphFor(codepoint, &found);
+        if (!glyph) {
+            // Only a full atlas loses printable glyphs, try again next draw
+            if (codepoint >= 0x20) layout.generation = 0;
+            previous = 0;
+            continue;
         }
-    };
+        const FontGlyph& ch = *glyph;
+        int shelf = glyphCache.getShelf(found);
+        if (shelf >= 0 && std::find(layout.shelves.begin(), layout.shelves.end(), shelf) == layout.shelves.end()) {
+            layout.shelves.push_back(shelf);
+        }
+
+        if (previous) x += glyphCache.kerning(previous, codepoint) / 64.0f * scale;
+        previous = codepoint;
+
+        float height = ch.Size.y * scale;
+        float ascent = ch.Bearing.y * scale;
+        layout.maxHeight = std::max(layout.maxHeight, height);
+        layout.maxAscent = std::max(layout.maxAscent, ascent);
+        layout.maxDescent = std::max(layout.maxDescent, height - ascent);
 
-    std::map<glm::vec4, std::vector<GLfloat>, Vec4Comparator> colorBatches;
-    std::map<glm::vec4, int, Vec4Comparator> charCounts;
-
-    for (const auto& text : textQueue) {
-        auto& colorVertices = colorBatches[text.color];
-        auto& colorCharCount = charCounts[text.color];
-
-        float startX = text.x;
-        float startY = text.y;
-
-        if (text.centered) {
-            float totalWidth = 0.0f;
-            float maxHeight = 0.0f;
-            for (const char& c : text.text) {
-                Character ch = characters[c];
-                totalWidth += (ch.Advance >> 6) * text.scale;
-                maxHeight = std::max(maxHeight, ch.Size.y * text.scale);
-            }
-            startX = text.x - (totalWidth / 2.0f);
-            startY = text.y - maxHeight;
+        if (ch.QuadSize.x > 0.0f) {
+            layout.glyphs.push_back({x, static_cast<uint32_t>(glyphCache.getSlot(found))});
         }
+        x += (ch.Advance >> 6) * scale;
+    }
+    layout.width = x;
+}
 
-        float x = startX;
-        for (const char& c : text.text) {
-            Character ch = characters[c];
+// Current glyphs for this batch: rebuilt when the glyph cache moved glyphs,
+// otherwise its shelves are kept resident
+void TextRenderer::refreshLayout(TextLayout& layout) {
+    if (layout.generation != glyphCache.getGeneration()) {
+        buildLayout(layout);
+    } else {
+        for (int shelf : layout.shelves) glyphCache.touch(shelf);
+    }
+}
 
-            float xpos = x + ch.Bearing.x * text.scale;
-            float ypos = startY - (ch.Size.y - ch.Bearing.y) * text.scale;
-            float w = ch.Size.x * text.scale;
-            float h = ch.Size.y * text.scale;
+// FNV-1a over the bytes, then the scale
+static uint64_t layoutHash(std::string_view text, float scale) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : text) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    uint32_t bits;
+    memcpy(&bits, &scale, sizeof(bits));
+    return (hash ^ bits) * 1099511628211ull;
+}
 
-            GLfloat quadVertices[] = {
-                xpos,     ypos,     ch.TexCoords[0].x, ch.TexCoords[1].y,
-                xpos,     ypos + h, ch.TexCoords[0].x, ch.TexCoords[0].y,
-                xpos + w, ypos,     ch.TexCoords[1].x, ch.TexCoords[1].y,
-                xpos + w, ypos + h, ch.TexCoords[1].x, ch.TexCoords[0].y
-            };
+// Direct mapped: a string that hashes onto a taken slot replaces it. Slots
+// keep their buffers, so replacing one allocates nothing once text of that
+// length has been there.
+TextLayout& TextRenderer::cachedLayout(std::string_view text, float scale) {
+    uint64_t hash = layoutHash(text, scale);
+    CachedLayout& slot = layoutCache[hash & (LAYOUT_CACHE_SIZE - 1)];
+
+    if (slot.hash == hash && slot.layout.scale == scale && slot.layout.text == text) {
+        refreshLayout(slot.layout);
+    } else {
+        slot.hash = hash;
+        slot.layout.text.assign(text.data(), text.size());
+        slot.layout.scale = scale;
+        buildLayout(slot.layout);
+    }
+    return slot.layout;
+}
 
-            colorVertices.insert(colorVertices.end(), std::begin(quadVertices), std::end(quadVertices));
-            colorCharCount++;
+void TextRenderer::draw(TextLayout& layout, float x, float y, glm::vec4 color) {
+    enqueue(layout, x, y, color, false, currentZIndex++);
+}
 
-            x += (ch.Advance >> 6) * text.scale;
-        }
+void TextRenderer::draw(TextLayout& layout, float x, float y, glm::vec4 color, int zIndex) {
+    enqueue(layout, x, y, color, false, zIndex);
+}
+
+void TextRenderer::drawCentered(TextLayout& layout, float x, float y, glm::vec4 color) {
+    enqueue(layout, x, y, color, true, currentZIndex++);
+}
+
+void TextRenderer::drawCentered(TextLayout& layout, float x, float y, glm::vec4 color, int zIndex) {
+    enqueue(layout, x, y, color, true, zIndex);
+}
+
+void TextRenderer::setRenderQueue(RenderQueue* queue) {
+    renderQueue = queue;
+    if (queue) shaderId = queue->registerShader(this);
+}
+
+void TextRenderer::flush() {
+    if (renderQueue || !initialized || textQueue.empty()) return;
+
+    // std::stable_sort takes a temporary buffer, the order field keeps
+    // equal zIndex in submission order without it. Usually already sorted.
+    auto byZ = [](const QueuedText& a, const QueuedText& b) {
+        return a.zIndex != b.zIndex ? a.zIndex < b.zIndex : a.order < b.order;
+    };
+    if (!std::is_sorted(textQueue.begin(), textQueue.end(), byZ)) {
+        std::sort(textQueue.begin(), textQueue.end(), byZ);
     }
 
-    for (const auto& [color, vertices] : colorBatches) {
-        int charCount = charCounts[color];
+    instances.clear();
+    glyphCache.beginBatch();
+    for (const QueuedText& text : textQueue) {
+        appendInstances(text);
+    }
+    drawInstances();
 
-        glUniform4f(glGetUniformLocation(shaderProgram, "textColor"),
-                    color.x, color.y, color.z, color.w);
+    clear();
+}
 
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(GLfloat), vertices.data());
+// The queue sorted the run by zIndex already
+void TextRenderer::drawRun(uint32_t, const uint32_t* items, size_t count) {
+    if (!initialized) return;
 
-        glDrawElements(GL_TRIANGLES, charCount * 6, GL_UNSIGNED_INT, 0);
+    instances.clear();
+    glyphCache.beginBatch();
+    for (size_t i = 0; i < count; i++) {
+        appendInstances(textQueue[items[i]]);
     }
+    drawInstances();
+}
 
-    cleanupRenderState();
+void TextRenderer::endFrame() {
     clear();
 }
 
+void TextRenderer::appendInstances(const QueuedText& text) {
+    GLubyte r = toUnorm8(text.color.r);
+    GLubyte g = toUnorm8(text.color.g);
+    GLubyte b = toUnorm8(text.color.b);
+    GLubyte a = toUnorm8(text.color.a);
+
+    float startX = text.x;
+    float startY = text.y;
+
+    // Plain strings are laid out through the cache, so a string drawn
+    // again next frame costs a hash and a compare
+    TextLayout& layout = text.layout ? *text.layout
+        : cachedLayout(std::string_view(textArena.data() + text.offset, text.length), text.scale);
+    if (text.layout) refreshLayout(layout);
+
+    if (text.centered) {
+        startX -= layout.width / 2.0f;
+        startY -= layout.maxHeight;
+    }
+
+    for (const TextLayout::Glyph& glyph : layout.glyphs) {
+        instances.push_back({startX + glyph.x, startY, layout.scale,
+                             static_cast<GLushort>(glyph.slot), 0, r, g, b, a});
+    }
+}
+
+void TextRenderer::drawInstances() {
+    size_t glyphCount = instances.size();
+    if (glyphCount == 0) return;
+
+    glyphCache.upload();
+    setupRenderState();
+    glState.bindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    // Chunks go into the ring back to back, each its own draw. A chunk
+    // always fits the ring, so it never grows; more glyphs take more chunks.
+    size_t ringCapacity = RING_GLYPHS;
+    for (size_t first = 0; first < glyphCount; first += CHUNK_GLYPHS) {
+        size_t count = std::min(CHUNK_GLYPHS, glyphCount - first);
+        reserveStream(ringGlyph, ringCapacity, count, sizeof(GlyphInstance));
+
+        glBufferSubData(GL_ARRAY_BUFFER, ringGlyph * sizeof(GlyphInstance), count * sizeof(GlyphInstance),
+                        instances.data() + first);
+        pointAttributes(ringGlyph);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(count));
+        ringGlyph += count;
+    }
+}
+
 void TextRenderer::clear() {
     textQueue.clear();
-    vertices.clear();
+    textArena.clear();
+    instances.clear();
     currentZIndex = 0;
 }
 
-void TextRenderer::getStringMetrics(const std::string& text, float scale,
+void TextRenderer::getStringMetrics(std::string_view text, float scale,
                                     float& width, float& maxHeight,
                                     float& maxAscent, float& maxDescent) {
     if (!initialized) {
         throw std::runtime_error("TextRenderer not initialized!");
     }
 
-    width = 0.0f;
-    maxHeight = 0.0f;
-    maxAscent = 0.0f;
-    maxDescent = 0.0f;
-
-    for (const char& c : text) {
-        Character ch = characters[c];
-        width += (ch.Advance >> 6) * scale;
-
-        float height = ch.Size.y * scale;
-        float ascent = ch.Bearing.y * scale;
-        float descent = (height - ascent);
+    const TextLayout& layout = cachedLayout(text, scale);
+    width = layout.width;
+    maxHeight = layout.maxHeight;
+    maxAscent = layout.maxAscent;
+    maxDescent = layout.maxDescent;
+}
 
-        maxHeight = std::max(maxHeight, height);
-        maxAscent = std::max(maxAscent, ascent);
-        maxDescent = std::max(maxDescent, descent);
-    }
+std::vector<float> TextRenderer::getLetterPositions(std::string_view text, float x, float scale) {
+    // Never more codepoints than bytes
+    std::vector<float> positions(text.size());
+    positions.resize(getLetterPositions(text, x, scale, positions.data(), positions.size()));
+    return positions;
 }
 
-std::vector<float> TextRenderer::getLetterPositions(const std::string& text, float x, float scale) {
+size_t TextRenderer::getLetterPositions(std::string_view text, float x, float scale, float* out, size_t capacity) {
     if (!initialized) {
         throw std::runtime_error("TextRenderer not initialized!");
     }
 
-    std::vector<float> positions;
-    positions.reserve(text.length());
-
+    // One entry per codepoint: where it starts, kerned like the layout
+    size_t count = 0;
     float currentX = x;
-    positions.push_back(currentX);
-
-    for (size_t i = 0; i < text.length(); i++) {
-        Character ch = characters[text[i]];
-        currentX += (ch.Advance >> 6) * scale;
-
-        if (i < text.length() - 1) {
-            positions.push_back(currentX);
-        }
+    uint32_t previous = 0;
+    const char* end = text.data() + text.size();
+    for (const char* p = text.data(); p < end;) {
+        uint32_t codepoint = decodeUtf8(p, end);
+        const FontGlyph* ch = glyphFor(codepoint);
+        if (ch && previous) currentX += glyphCache.kerning(previous, codepoint) / 64.0f * scale;
+        previous = ch ? codepoint : 0;
+
+        if (count < capacity) out[count] = currentX;
+        count++;
+        if (ch) currentX += (ch->Advance >> 6) * scale;
     }
 
-    return positions;
-}
\ No newline at end of file
+    return count;
+}
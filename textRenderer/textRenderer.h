@@ -1,69 +1,168 @@
 // TextRenderer.h
 #pragma once
 #include <string>
-#include <map>
+#include <string_view>
 #include <vector>
 #include <glm/glm.hpp>
 #include <GLES3/gl3.h>
-#include <ft2build.h>
-#include FT_FREETYPE_H
+#include "fontAtlas.h"
+#include "glyphCache.h"
+#include "renderQueue/renderQueue.h"
 
-class TextRenderer {
+class TextRenderer;
+
+// A string laid out once: glyph ids and pen offsets plus its metrics, for
+// labels that do not change. Drawing one only translates and colors the
+// prebuilt glyphs. It is rebuilt by the renderer on its own when
+// the glyph cache moved glyphs around since it was made.
+class TextLayout {
 public:
+    const std::string& getText() const { return text; }
+    float getScale() const { return scale; }
+    // Same values getStringMetrics reports for the text; width includes kerning
+    float getWidth() const { return width; }
+    float getHeight() const { return maxHeight; }
+    float getAscent() const { return maxAscent; }
+    float getDescent() const { return maxDescent; }
+    bool empty() const { return glyphs.empty(); }
+
+private:
+    friend class TextRenderer;
+
+    // Visible glyph: pen x relative to the layout origin, glyph cache slot
+    struct Glyph {
+        float x;
+        uint32_t slot;
+    };
+
+    std::string text;
+    float scale = 1.0f;
+    float width = 0.0f, maxHeight = 0.0f, maxAscent = 0.0f, maxDescent = 0.0f;
+    std::vector<Glyph> glyphs;
+    std::vector<int> shelves;       // glyph cache shelves the glyphs sample
+    uint32_t generation = 0;        // glyph cache generation the slots are from
+};
+
+class TextRenderer : public RenderBackend {
+public:
+    // Glyph metrics and the `scale` argument are relative to FontAtlas::PIXEL_SIZE
+    using AtlasMode = FontAtlas::Mode;
+
     TextRenderer();
     ~TextRenderer();
 
-    bool initialize(const char* fontPath, int screenWidth, int screenHeight);
+    // fontPath is either a baked .font blob (tools/fontBake) or a TTF whose
+    // glyphs rasterize on first use in `mode`. TTFs fail in
+    // TEXT_RENDERER_NO_FREETYPE builds.
+    bool initialize(const char* fontPath, int screenWidth, int screenHeight,
+                    AtlasMode mode = FontAtlas::ATLAS_SDF);
+    AtlasMode getAtlasMode() const { return atlasMode; }
+
+    // Codepoints the baked atlas lacks are rasterized from this TTF on first
+    // use (FreeType builds only). A TTF passed to initialize is used already.
+    bool setDynamicFont(const char* fontPath);
+
     void setScreenSize(int width, int height);
     
-    void draw(const std::string& text, float x, float y, float scale, glm::vec4 color = glm::vec4(1.0f));
-    void draw(const std::string& text, float x, float y, float scale, glm::vec4 color, int zIndex);
-    void drawCentered(const std::string& text, float x, float y, float scale, glm::vec4 color = glm::vec4(1.0f));
-    void drawCentered(const std::string& text, float x, float y, float scale, glm::vec4 color, int zIndex);
+    // Text is UTF-8, copied into the queue's arena so it need not outlive the call
+    void draw(std::string_view text, float x, float y, float scale, glm::vec4 color = glm::vec4(1.0f));
+    void draw(std::string_view text, float x, float y, float scale, glm::vec4 color, int zIndex);
+    void drawCentered(std::string_view text, float x, float y, float scale, glm::vec4 color = glm::vec4(1.0f));
+    void drawCentered(std::string_view text, float x, float y, float scale, glm::vec4 color, int zIndex);
+
+    // Layouts are queued by reference, keep them alive and in place until flush
+    TextLayout createLayout(std::string_view text, float scale);
+    void draw(TextLayout& layout, float x, float y, glm::vec4 color = glm::vec4(1.0f));
+    void draw(TextLayout& layout, float x, float y, glm::vec4 color, int zIndex);
+    void drawCentered(TextLayout& layout, float x, float y, glm::vec4 color = glm::vec4(1.0f));
+    void drawCentered(TextLayout& layout, float x, float y, glm::vec4 color, int zIndex);
     
+    // Draws go to the queue from then on, in its current layer and pass with
+    // zIndex as depth, and flush() does nothing; the queue draws them.
+    // Queued layouts must then stay in place until the queue flushes.
+    void setRenderQueue(RenderQueue* queue);
     void flush();
     void clear();
+
+    void drawRun(uint32_t shader, const uint32_t* items, size_t count) override;
+    void endFrame() override;
     
-    void getStringMetrics(const std::string& text, float scale,
+    void getStringMetrics(std::string_view text, float scale,
                           float& width, float& maxHeight,
                           float& maxAscent, float& maxDescent);
-    std::vector<float> getLetterPositions(const std::string& text, float x, float scale);
+    // Text is UTF-8; positions are per codepoint
+    std::vector<float> getLetterPositions(std::string_view text, float x, float scale);
+    // Same into a caller buffer: writes at most capacity, returns the count
+    // the whole string needs. FontMetrics measures without a GL context.
+    size_t getLetterPositions(std::string_view text, float x, float scale, float* out, size_t capacity);
 
 private:
-    struct Character {
-        glm::vec2 TexCoords[2];
-        glm::ivec2 Size;
-        glm::ivec2 Bearing;
-        GLuint Advance;
+    // Glyphs per draw and glyphs the streaming VBO holds
+    static constexpr size_t CHUNK_GLYPHS = 16384;
+    static constexpr size_t RING_GLYPHS = CHUNK_GLYPHS * 2;
+
+    // Strings laid out recently, by hash of (text, scale). A power of two.
+    static const size_t LAYOUT_CACHE_SIZE = 1024;
+
+    struct CachedLayout {
+        uint64_t hash = 0;
+        TextLayout layout;
+    };
+
+    // One instance per glyph; the vertex shader expands it to a quad from
+    // the glyph cache metrics of the slot. RGBA8 is normalized to 0..1.
+    struct GlyphInstance {
+        GLfloat x, y, scale;    // pen position
+        GLushort slot, padding; // the atlas tops out at a few thousand slots
+        GLubyte r, g, b, a;
     };
 
+    // The text lives in textArena, an offset survives the arena growing.
+    // Layout draws reference the layout instead.
     struct QueuedText {
-        std::string text;
+        TextLayout* layout;
+        uint32_t offset, length;
         float x, y, scale;
         glm::vec4 color;
         bool centered;
         int zIndex;
+        uint32_t order;     // submission order, breaks zIndex ties
     };
 
     GLuint compileShader(GLenum type, const char* source);
-    bool generateAtlas(FT_Face face);
+    // found, when given, receives the codepoint whose glyph was returned
+    const FontGlyph* glyphFor(uint32_t codepoint, uint32_t* found = nullptr);
     void setupRenderState();
-    void cleanupRenderState();
+    void pointAttributes(size_t firstInstance);
+    void enqueue(std::string_view text, float x, float y, float scale, glm::vec4 color, bool centered, int zIndex);
+    void enqueue(TextLayout& layout, float x, float y, glm::vec4 color, bool centered, int zIndex);
+    void pushToQueue(int zIndex);
+    void appendInstances(const QueuedText& text);
+    void drawInstances();   // instances through the VBO ring, then cleared by the caller
+    void buildLayout(TextLayout& layout);
+    void refreshLayout(TextLayout& layout);
+    TextLayout& cachedLayout(std::string_view text, float scale);
 
     bool initialized;
+    AtlasMode atlasMode = FontAtlas::ATLAS_BITMAP;
     int screenWidth, screenHeight;
     
-    GLuint atlasTexture;
     GLuint shaderProgram;
-    GLuint vao, vbo, ibo;
+    GLuint vao, vbo;
+    GLint projectionLoc = -1;
+    size_t ringGlyph = 0;     // next free instance in the VBO ring
     
-    std::map<char, Character> characters;
+    GlyphCache glyphCache;
     std::vector<QueuedText> textQueue;
-    std::vector<GLuint> indices;
-    std::vector<GLfloat> vertices;
+    std::vector<char> textArena;         // queued strings back to back, reset by flush
+    std::vector<CachedLayout> layoutCache;
+    std::vector<GlyphInstance> instances;   // reused between flushes
     
     int currentZIndex;
+    RenderQueue* renderQueue = nullptr;
+    uint32_t shaderId = 0;
     
     const char* vertexShaderSource;
     const char* fragmentShaderSource;
+    const char* sdfFragmentShaderSource;
 };
\ No newline at end of file
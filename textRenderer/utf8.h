@@ -0,0 +1,41 @@
+// Utf8.h
+#pragma once
+#include <cstdint>
+
+// Decodes one UTF-8 sequence and advances p past it. Malformed or truncated
+// sequences decode to U+FFFD, consuming only their first byte.
+inline uint32_t decodeUtf8(const char*& p, const char* end) {
+    unsigned char lead = static_cast<unsigned char>(*p++);
+    if (lead < 0x80) return lead;
+
+    int extra;
+    uint32_t codepoint;
+    if ((lead & 0xE0) == 0xC0) {
+        extra = 1;
+        codepoint = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        extra = 2;
+        codepoint = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        extra = 3;
+        codepoint = lead & 0x07;
+    } else {
+        return 0xFFFD;
+    }
+
+    if (end - p < extra) return 0xFFFD;
+    for (int i = 0; i < extra; i++) {
+        unsigned char next = static_cast<unsigned char>(p[i]);
+        if ((next & 0xC0) != 0x80) return 0xFFFD;
+        codepoint = (codepoint << 6) | (next & 0x3F);
+    }
+    p += extra;
+
+    // Overlong forms, UTF-16 surrogates and values past U+10FFFF
+    static const uint32_t minimum[] = {0, 0x80, 0x800, 0x10000};
+    if (codepoint < minimum[extra] || codepoint > 0x10FFFF ||
+        (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        return 0xFFFD;
+    }
+    return codepoint;
+}
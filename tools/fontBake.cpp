@@ -0,0 +1,64 @@
+// fontBake.cpp
+// Bakes a TTF into the .font blob TextRenderer loads without FreeType:
+// glyph metrics and kerning pairs for ASCII plus the R8 atlas (SDF by default), PackBits
+// compressed unless --raw is given.
+//
+//   fontBake <font.ttf> <out.font> [--bitmap] [--raw]
+//
+// Natively it is the fontBake CMake target. The checked-in
+// assets/fonts/roboto/Roboto-Medium.font was made with
+//   fontBake assets/fonts/roboto/Roboto-Medium.ttf assets/fonts/roboto/Roboto-Medium.font
+#include "textRenderer/fontAtlas.h"
+
+#include <cstdio>
+#include <cstring>
+
+int main(int argc, char** argv) {
+    const char* input = nullptr;
+    const char* output = nullptr;
+    FontAtlas::Mode mode = FontAtlas::ATLAS_SDF;
+    bool compress = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bitmap") == 0) {
+            mode = FontAtlas::ATLAS_BITMAP;
+        } else if (strcmp(argv[i], "--raw") == 0) {
+            compress = false;
+        } else if (!input) {
+            input = argv[i];
+        } else if (!output) {
+            output = argv[i];
+        } else {
+            input = nullptr;
+            break;
+        }
+    }
+
+    if (!input || !output) {
+        fprintf(stderr, "usage: fontBake <font.ttf> <out.font> [--bitmap] [--raw]\n");
+        return 2;
+    }
+
+    FontAtlas atlas;
+    if (!bakeFontAtlas(input, mode, atlas)) {
+        fprintf(stderr, "fontBake: cannot bake %s\n", input);
+        return 1;
+    }
+
+    if (!saveFontAtlas(output, atlas, compress)) {
+        return 1;
+    }
+
+    FILE* file = fopen(output, "rb");
+    long size = 0;
+    if (file) {
+        fseek(file, 0, SEEK_END);
+        size = ftell(file);
+        fclose(file);
+    }
+
+    printf("%s: %s atlas %dx%d, %zu kerning pairs, %ld bytes (%zu byte atlas)\n", output,
+           atlas.mode == FontAtlas::ATLAS_SDF ? "SDF" : "bitmap",
+           atlas.width, atlas.height, atlas.kerning.size(), size, atlas.pixels.size());
+    return 0;
+}